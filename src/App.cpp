@@ -216,6 +216,7 @@ void App::launch(Project const& project)
         return;
     }
     version_manager().install_ifn_and_launch(*version, FileToOpen{project.file_path()});
+    mark_as_outdated_in_project_catalog(project);
 }
 
 void App::launch(std::filesystem::path const& project_file_path)
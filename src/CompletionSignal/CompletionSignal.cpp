@@ -0,0 +1,61 @@
+#include "CompletionSignal.hpp"
+
+void CompletionSignal::then(std::function<void(bool success)> callback)
+{
+    auto success = std::optional<bool>{};
+    {
+        auto lock = std::unique_lock{_mutex};
+        if (!_success.has_value())
+        {
+            _callbacks.push_back(std::move(callback));
+            return;
+        }
+        success = _success;
+    }
+    callback(*success); // Outside of the lock, so that the callback can register other callbacks
+}
+
+void CompletionSignal::complete(bool success)
+{
+    auto callbacks = std::vector<std::function<void(bool)>>{};
+    {
+        auto lock = std::unique_lock{_mutex};
+        assert(!_success.has_value());
+        _success = success;
+        std::swap(callbacks, _callbacks);
+    }
+    for (auto const& callback : callbacks) // Outside of the lock, so that the callbacks can register other callbacks
+        callback(success);
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include <thread>
+#include "doctest/doctest.h"
+
+TEST_CASE("CompletionSignal calls the callbacks exactly once, whether they are registered before or after it completes")
+{
+    auto signal  = CompletionSignal{};
+    auto results = std::vector<bool>{};
+    signal.then([&](bool success) { results.push_back(success); });
+    CHECK(results.empty());
+    signal.complete(true);
+    CHECK(results == std::vector<bool>{true});
+    signal.then([&](bool success) { results.push_back(success); });
+    CHECK(results == std::vector<bool>{true, true});
+}
+
+TEST_CASE("CompletionSignal never misses a callback registered while it completes on another thread")
+{
+    static constexpr int nb_callbacks = 1000;
+
+    auto signal       = CompletionSignal{};
+    auto nb_calls     = std::atomic<int>{0};
+    auto registration = std::thread{[&]() {
+        for (int i = 0; i < nb_callbacks; ++i)
+            signal.then([&](bool) { nb_calls++; });
+    }};
+    signal.complete(false);
+    registration.join();
+    CHECK(nb_calls.load() == nb_callbacks);
+}
+#endif
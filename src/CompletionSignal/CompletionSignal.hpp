@@ -0,0 +1,22 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/// Calls callbacks once something completes (e.g. a task), or immediately if it has already completed.
+/// This lets us start what depends on a task the very moment it completes, instead of submitting it with a WaitToExecuteTask that the task manager has to poll until it notices.
+/// Can be used from any thread.
+class CompletionSignal {
+public:
+    /// `callback` receives true iff it completed successfully.
+    /// It is called on the thread that calls complete(), or on this thread if it has already completed.
+    void then(std::function<void(bool success)> callback);
+    /// Must only be called once
+    void complete(bool success);
+
+private:
+    std::mutex                             _mutex{};
+    std::optional<bool>                    _success{}; // Set once it has completed
+    std::vector<std::function<void(bool)>> _callbacks{};
+};
@@ -0,0 +1,67 @@
+#include "CopyOnWrite.hpp"
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include <thread>
+#include "doctest/doctest.h"
+
+TEST_CASE("CopyOnWrite readers always see a consistent value while writers modify it")
+{
+    static constexpr int nb_writers           = 4;
+    static constexpr int nb_writes_per_writer = 500;
+    static constexpr int nb_readers           = 4;
+
+    auto value = CopyOnWrite<std::vector<int>>{};
+
+    auto is_done = std::atomic<bool>{false};
+    auto readers = std::vector<std::thread>{};
+    auto errors  = std::atomic<int>{0};
+    for (int i = 0; i < nb_readers; ++i)
+    {
+        readers.emplace_back([&]() {
+            auto previous_size = size_t{0};
+            while (!is_done.load())
+            {
+                auto const snapshot = value.snapshot();
+                if (snapshot->size() < previous_size // Writes are never lost
+                    || !std::is_sorted(snapshot->begin(), snapshot->end()))
+                {
+                    errors++;
+                }
+                previous_size = snapshot->size();
+            }
+        });
+    }
+
+    auto writers = std::vector<std::thread>{};
+    for (int i = 0; i < nb_writers; ++i)
+    {
+        writers.emplace_back([&, i]() {
+            for (int j = 0; j < nb_writes_per_writer; ++j)
+            {
+                value.modify([&](std::vector<int>& numbers) {
+                    auto const number = i * nb_writes_per_writer + j;
+                    numbers.insert(std::lower_bound(numbers.begin(), numbers.end(), number), number); // Keep it sorted
+                });
+            }
+        });
+    }
+
+    for (auto& writer : writers)
+        writer.join();
+    is_done.store(true);
+    for (auto& reader : readers)
+        reader.join();
+
+    CHECK(errors.load() == 0);
+    CHECK(value.snapshot()->size() == static_cast<size_t>(nb_writers * nb_writes_per_writer));
+}
+
+TEST_CASE("CopyOnWrite snapshots are not affected by later modifications")
+{
+    auto       value    = CopyOnWrite<std::string>{"a"};
+    auto const snapshot = value.snapshot();
+    value.modify([](std::string& str) { str += "b"; });
+    CHECK(*snapshot == "a");
+    CHECK(*value.snapshot() == "ab");
+}
+#endif
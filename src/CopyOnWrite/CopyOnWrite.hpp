@@ -0,0 +1,41 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/// Shares a value between threads, with readers that never wait for writers:
+/// - Readers get an immutable snapshot of the value, that stays valid for as long as they hold it, even if the value is modified in the meantime
+/// - Writers modify a copy of the value, and then publish it for the next readers. They are serialized, so no modification is ever lost
+/// Readers only lock for the time it takes to copy a shared_ptr (we don't use std::atomic<std::shared_ptr> because not all the standard libraries we build with support it yet)
+template<typename T>
+class CopyOnWrite {
+public:
+    explicit CopyOnWrite(T value = {})
+        : _value{std::make_shared<T const>(std::move(value))}
+    {}
+
+    auto snapshot() const -> std::shared_ptr<T const>
+    {
+        auto lock = std::unique_lock{_value_mutex};
+        return _value;
+    }
+
+    void modify(std::function<void(T&)> const& callback)
+    {
+        auto lock      = std::unique_lock{_writers_mutex};
+        auto new_value = std::make_shared<T>(*snapshot());
+        callback(*new_value);
+
+        auto old_value = std::shared_ptr<T const>{std::move(new_value)};
+        {
+            auto value_lock = std::unique_lock{_value_mutex};
+            std::swap(_value, old_value);
+        }
+        // The old value is destroyed here if no reader holds it anymore, outside of the lock so that readers don't wait for it
+    }
+
+private:
+    std::shared_ptr<T const> _value;
+    mutable std::mutex       _value_mutex{};
+    std::mutex               _writers_mutex{};
+};
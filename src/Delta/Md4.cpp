@@ -0,0 +1,92 @@
+#include "Md4.hpp"
+#include <bit>
+
+static void process_block(std::array<uint32_t, 4>& state, uint8_t const* block)
+{
+    auto x = std::array<uint32_t, 16>{};
+    for (size_t i = 0; i < 16; ++i)
+        x[i] = static_cast<uint32_t>(block[4 * i]) | (static_cast<uint32_t>(block[4 * i + 1]) << 8) | (static_cast<uint32_t>(block[4 * i + 2]) << 16) | (static_cast<uint32_t>(block[4 * i + 3]) << 24); // NOLINT(*pointer-arithmetic)
+
+    auto a = state[0];
+    auto b = state[1];
+    auto c = state[2];
+    auto d = state[3];
+
+    auto const f = [](uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (~x & z); };
+    auto const g = [](uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (x & z) | (y & z); };
+    auto const h = [](uint32_t x, uint32_t y, uint32_t z) { return x ^ y ^ z; };
+
+    for (size_t const k : std::array<size_t, 4>{0, 4, 8, 12})
+    {
+        a = std::rotl(a + f(b, c, d) + x[k + 0], 3);
+        d = std::rotl(d + f(a, b, c) + x[k + 1], 7);
+        c = std::rotl(c + f(d, a, b) + x[k + 2], 11);
+        b = std::rotl(b + f(c, d, a) + x[k + 3], 19);
+    }
+    for (size_t const k : std::array<size_t, 4>{0, 1, 2, 3})
+    {
+        a = std::rotl(a + g(b, c, d) + x[k + 0] + 0x5A827999, 3);
+        d = std::rotl(d + g(a, b, c) + x[k + 4] + 0x5A827999, 5);
+        c = std::rotl(c + g(d, a, b) + x[k + 8] + 0x5A827999, 9);
+        b = std::rotl(b + g(c, d, a) + x[k + 12] + 0x5A827999, 13);
+    }
+    for (size_t const k : std::array<size_t, 4>{0, 2, 1, 3})
+    {
+        a = std::rotl(a + h(b, c, d) + x[k + 0] + 0x6ED9EBA1, 3);
+        d = std::rotl(d + h(a, b, c) + x[k + 8] + 0x6ED9EBA1, 9);
+        c = std::rotl(c + h(d, a, b) + x[k + 4] + 0x6ED9EBA1, 11);
+        b = std::rotl(b + h(c, d, a) + x[k + 12] + 0x6ED9EBA1, 15);
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+auto md4(uint8_t const* data, size_t size) -> std::array<uint8_t, 16>
+{
+    auto state = std::array<uint32_t, 4>{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+    size_t const nb_full_blocks = size / 64;
+    for (size_t i = 0; i < nb_full_blocks; ++i)
+        process_block(state, data + 64 * i); // NOLINT(*pointer-arithmetic)
+
+    // Padding: a 1 bit, zeros, and the size of the message in bits
+    auto         last_blocks = std::array<uint8_t, 128>{};
+    size_t const remaining   = size - 64 * nb_full_blocks;
+    std::copy(data + 64 * nb_full_blocks, data + size, last_blocks.begin()); // NOLINT(*pointer-arithmetic)
+    last_blocks[remaining] = 0x80;
+
+    size_t const   padded_size  = remaining < 56 ? 64 : 128;
+    uint64_t const size_in_bits = static_cast<uint64_t>(size) * 8;
+    for (size_t i = 0; i < 8; ++i)
+        last_blocks[padded_size - 8 + i] = static_cast<uint8_t>(size_in_bits >> (8 * i));
+    for (size_t offset = 0; offset < padded_size; offset += 64)
+        process_block(state, last_blocks.data() + offset); // NOLINT(*pointer-arithmetic)
+
+    auto res = std::array<uint8_t, 16>{};
+    for (size_t i = 0; i < 16; ++i)
+        res[i] = static_cast<uint8_t>(state[i / 4] >> (8 * (i % 4)));
+    return res;
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+
+static auto md4_hex(std::string_view message) -> std::string
+{
+    auto res = std::string{};
+    for (auto const byte : md4(reinterpret_cast<uint8_t const*>(message.data()), message.size())) // NOLINT(*reinterpret-cast)
+        res += fmt::format("{:02x}", byte);
+    return res;
+}
+
+TEST_CASE("MD4")
+{
+    // Test vectors from RFC 1320
+    CHECK(md4_hex("") == "31d6cfe0d16ae931b73c59d7e0c089c0");
+    CHECK(md4_hex("abc") == "a448017aaf21d8525fc10ae87aa6729d");
+    CHECK(md4_hex("12345678901234567890123456789012345678901234567890123456789012345678901234567890") == "e33b4ddc9c38f2199c3e7b164fcc0536");
+}
+#endif
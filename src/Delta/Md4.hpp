@@ -0,0 +1,5 @@
+#pragma once
+
+/// MD4 is what the zsync format uses to identify blocks. It is not available in OpenSSL 3 anymore (except through the legacy provider), and it is very short to implement.
+/// NB: MD4 is broken as a cryptographic hash, we only use it to find identical blocks, and the integrity of the whole file is then checked with its SHA-1
+auto md4(uint8_t const* data, size_t size) -> std::array<uint8_t, 16>;
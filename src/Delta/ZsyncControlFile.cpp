@@ -0,0 +1,111 @@
+#include "ZsyncControlFile.hpp"
+#include <charconv>
+
+static auto parse_number(std::string_view str) -> std::optional<uint64_t>
+{
+    auto       res         = uint64_t{};
+    auto const [ptr, error] = std::from_chars(str.data(), str.data() + str.size(), res); // NOLINT(*pointer-arithmetic)
+    if (error != std::errc{} || ptr != str.data() + str.size())                            // NOLINT(*pointer-arithmetic)
+        return std::nullopt;
+    return res;
+}
+
+/// Parses "2,2,5" into {2, 2, 5}
+static auto parse_hash_lengths(std::string_view str) -> std::optional<std::array<uint64_t, 3>>
+{
+    auto res = std::array<uint64_t, 3>{};
+    for (size_t i = 0; i < 3; ++i)
+    {
+        auto const comma  = str.find(',');
+        auto const number = parse_number(str.substr(0, comma));
+        if (!number || (i < 2) == (comma == std::string_view::npos))
+            return std::nullopt;
+        res[i] = *number;
+        str.remove_prefix(comma == std::string_view::npos ? str.size() : comma + 1);
+    }
+    return res;
+}
+
+auto parse_zsync_control_file(std::string_view content) -> std::optional<ZsyncControlFile>
+{
+    auto res          = ZsyncControlFile{};
+    auto hash_lengths = std::optional<std::array<uint64_t, 3>>{};
+
+    // The header is made of "Key: value" lines, and ends with an empty line
+    while (true)
+    {
+        auto const end_of_line = content.find('\n');
+        if (end_of_line == std::string_view::npos)
+            return std::nullopt;
+        auto const line = content.substr(0, end_of_line);
+        content.remove_prefix(end_of_line + 1);
+        if (line.empty())
+            break;
+
+        auto const separator = line.find(": ");
+        if (separator == std::string_view::npos)
+            return std::nullopt;
+        auto const key   = line.substr(0, separator);
+        auto const value = line.substr(separator + 2);
+        if (key == "Blocksize")
+            res.block_size = parse_number(value).value_or(0);
+        else if (key == "Length")
+            res.length = parse_number(value).value_or(0);
+        else if (key == "Hash-Lengths")
+            hash_lengths = parse_hash_lengths(value);
+        else if (key == "SHA-1")
+            res.sha1 = value;
+        // Ignore the other keys (Filename, MTime, URL, etc.), we already know where to download the file from
+    }
+
+    if (res.block_size == 0 || res.length == 0 || res.sha1.empty() || !hash_lengths)
+        return std::nullopt;
+    res.seq_matches    = (*hash_lengths)[0];
+    res.rsum_bytes     = (*hash_lengths)[1];
+    res.checksum_bytes = (*hash_lengths)[2];
+    if (res.seq_matches < 1 || res.seq_matches > 2 || res.rsum_bytes < 1 || res.rsum_bytes > 4 || res.checksum_bytes < 3 || res.checksum_bytes > 16)
+        return std::nullopt;
+
+    // Then comes, for each block, the end of its weak checksum (stored as a, then b, both big-endian) followed by the beginning of its MD4
+    auto const nb_blocks = (res.length + res.block_size - 1) / res.block_size;
+    if (content.size() != nb_blocks * (res.rsum_bytes + res.checksum_bytes))
+        return std::nullopt;
+    res.blocks.reserve(nb_blocks);
+    for (size_t i = 0; i < nb_blocks; ++i)
+    {
+        auto rsum = std::array<uint8_t, 4>{};
+        std::copy_n(content.begin(), res.rsum_bytes, rsum.end() - static_cast<std::ptrdiff_t>(res.rsum_bytes));
+        content.remove_prefix(res.rsum_bytes);
+
+        auto block   = ZsyncControlFile::Block{};
+        block.rsum_a = static_cast<uint16_t>((rsum[0] << 8) | rsum[1]);
+        block.rsum_b = static_cast<uint16_t>((rsum[2] << 8) | rsum[3]);
+        std::copy_n(content.begin(), res.checksum_bytes, block.checksum.begin());
+        content.remove_prefix(res.checksum_bytes);
+        res.blocks.push_back(block);
+    }
+    return res;
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+TEST_CASE("Parsing a zsync control file")
+{
+    auto content = "zsync: 0.6.2\nFilename: Coollab.AppImage\nBlocksize: 4\nLength: 6\nHash-Lengths: 2,2,3\nSHA-1: 0123456789abcdef\n\n"s;
+    content += "\x01\x02"s + "abc"s; // Block 0
+    content += "\x03\x04"s + "def"s; // Block 1
+
+    auto const control_file = parse_zsync_control_file(content);
+    REQUIRE(control_file.has_value());
+    CHECK(control_file->block_size == 4);
+    CHECK(control_file->length == 6);
+    CHECK(control_file->seq_matches == 2);
+    CHECK(control_file->sha1 == "0123456789abcdef");
+    REQUIRE(control_file->blocks.size() == 2);
+    CHECK(control_file->blocks[0].rsum_a == 0);
+    CHECK(control_file->blocks[0].rsum_b == 0x0102);
+    CHECK(control_file->blocks[1].checksum[0] == 'd');
+
+    CHECK(!parse_zsync_control_file(content.substr(0, content.size() - 1)).has_value()); // Truncated file
+}
+#endif
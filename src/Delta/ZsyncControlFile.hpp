@@ -0,0 +1,22 @@
+#pragma once
+
+/// The ".zsync" file published next to a release asset. It describes the asset as a list of blocks, with two checksums per block, so that we can find which of these blocks we already have in an older version of the file.
+/// See http://zsync.moria.org.uk/ for the format.
+struct ZsyncControlFile {
+    struct Block {
+        uint16_t                rsum_a{}; // Weak rolling checksum, cheap to update when sliding over a file byte by byte
+        uint16_t                rsum_b{};
+        std::array<uint8_t, 16> checksum{}; // Beginning of the MD4 of the block (only the first `checksum_bytes` bytes are meaningful)
+    };
+
+    size_t             block_size{};
+    uint64_t           length{};      // Size of the whole file
+    size_t             seq_matches{}; // Number of consecutive blocks that need to match for us to trust a match
+    size_t             rsum_bytes{};  // Number of bytes of the weak checksum that are stored in the file
+    size_t             checksum_bytes{};
+    std::string        sha1{}; // Of the whole file, to check the result
+    std::vector<Block> blocks{};
+};
+
+/// Returns nullopt if the content is not a valid zsync control file
+auto parse_zsync_control_file(std::string_view content) -> std::optional<ZsyncControlFile>;
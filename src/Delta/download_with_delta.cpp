@@ -0,0 +1,408 @@
+#include "download_with_delta.hpp"
+#include <fstream>
+#include <span>
+#include "Hash/Sha1.hpp"
+#include "Md4.hpp"
+#include "Zip/MappedFile.hpp"
+#include "ZsyncControlFile.hpp"
+#include "make_http_request.hpp"
+
+static constexpr size_t max_nb_of_requests{64};
+
+/// Weak checksum from rsync, computed the same way as zsync does
+struct RollingChecksum {
+    uint16_t a{};
+    uint16_t b{};
+};
+
+static auto rolling_checksum(uint8_t const* data, size_t size) -> RollingChecksum
+{
+    auto res = RollingChecksum{};
+    for (size_t i = 0; i < size; ++i)
+    {
+        res.a = static_cast<uint16_t>(res.a + data[i]);              // NOLINT(*pointer-arithmetic)
+        res.b = static_cast<uint16_t>(res.b + (size - i) * data[i]); // NOLINT(*pointer-arithmetic)
+    }
+    return res;
+}
+
+/// Finds the blocks that have a given weak checksum
+class BlockIndex {
+public:
+    explicit BlockIndex(ZsyncControlFile const& control_file)
+        // The control file only stores the last bytes of the checksum, so we must ignore the other ones when comparing
+        : _a_mask{static_cast<uint16_t>(control_file.rsum_bytes <= 2 ? 0 : control_file.rsum_bytes == 3 ? 0xFF : 0xFFFF)}
+        , _b_mask{static_cast<uint16_t>(control_file.rsum_bytes == 1 ? 0xFF : 0xFFFF)}
+    {
+        for (size_t i = 0; i < control_file.blocks.size(); ++i)
+            _blocks[key(control_file.blocks[i].rsum_a, control_file.blocks[i].rsum_b)].push_back(i);
+    }
+
+    auto blocks_with(RollingChecksum checksum) const -> std::vector<size_t> const*
+    {
+        auto const it = _blocks.find(key(checksum.a, checksum.b));
+        return it == _blocks.end() ? nullptr : &it->second;
+    }
+
+    auto matches(RollingChecksum checksum, ZsyncControlFile::Block const& block) const -> bool
+    {
+        return key(checksum.a, checksum.b) == key(block.rsum_a, block.rsum_b);
+    }
+
+private:
+    auto key(uint16_t a, uint16_t b) const -> uint32_t
+    {
+        return (static_cast<uint32_t>(a & _a_mask) << 16) | static_cast<uint32_t>(b & _b_mask);
+    }
+
+private:
+    uint16_t                                          _a_mask;
+    uint16_t                                          _b_mask;
+    std::unordered_map<uint32_t, std::vector<size_t>> _blocks{};
+};
+
+static auto checksum_matches(ZsyncControlFile const& control_file, ZsyncControlFile::Block const& block, std::array<uint8_t, 16> const& md4_of_data) -> bool
+{
+    return std::equal(md4_of_data.begin(), md4_of_data.begin() + static_cast<std::ptrdiff_t>(control_file.checksum_bytes), block.checksum.begin());
+}
+
+/// For each block of the new file, returns the position in the base file where we found the same content, if any
+/// Slides over the base file byte by byte, like rsync: thanks to the rolling checksum each step is cheap, and we only compute an MD4 when the weak checksum matches
+static auto find_known_blocks(ZsyncControlFile const& control_file, std::span<uint8_t const> base, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> std::vector<std::optional<uint64_t>>
+{
+    static constexpr uint64_t bytes_between_progress_updates{1'000'000};
+
+    auto       res        = std::vector<std::optional<uint64_t>>(control_file.blocks.size());
+    auto const block_size = control_file.block_size;
+    if (base.size() < block_size)
+        return res;
+
+    auto const index = BlockIndex{control_file};
+
+    // When the control file requires 2 consecutive matches, it is because its checksums are too short to be trusted on a single block
+    auto const next_block_matches = [&](size_t block_id, uint64_t offset) {
+        if (control_file.seq_matches < 2 || block_id + 1 >= control_file.blocks.size())
+            return true;
+        if (offset + 2 * block_size > base.size())
+            return false;
+        auto const* const next_data  = &base[offset + block_size];
+        auto const&       next_block = control_file.blocks[block_id + 1];
+        return index.matches(rolling_checksum(next_data, block_size), next_block)
+               && checksum_matches(control_file, next_block, md4(next_data, block_size));
+    };
+
+    auto offset        = uint64_t{0};
+    auto checksum      = rolling_checksum(base.data(), block_size);
+    auto next_progress = bytes_between_progress_updates;
+    while (offset + block_size <= base.size())
+    {
+        if (offset >= next_progress)
+        {
+            if (wants_to_cancel())
+                return res;
+            set_progress(static_cast<float>(offset) / static_cast<float>(base.size()));
+            next_progress += bytes_between_progress_updates;
+        }
+
+        auto has_found_a_block = false;
+        if (auto const* const candidates = index.blocks_with(checksum))
+        {
+            auto const md4_of_data = md4(&base[offset], block_size);
+            for (auto const block_id : *candidates)
+            {
+                if (res[block_id].has_value() || !checksum_matches(control_file, control_file.blocks[block_id], md4_of_data))
+                    continue;
+                if (!next_block_matches(block_id, offset))
+                    continue;
+                res[block_id]     = offset;
+                has_found_a_block = true; // Don't stop here, several blocks of the new file might have the same content
+            }
+        }
+
+        if (has_found_a_block)
+        {
+            // Skip the whole block we just found, it is unlikely that another block starts in the middle of it
+            offset += block_size;
+            if (offset + block_size <= base.size())
+                checksum = rolling_checksum(&base[offset], block_size);
+        }
+        else
+        {
+            if (offset + block_size >= base.size())
+                break;
+            // Slide the window by one byte
+            auto const old_byte = base[offset];
+            auto const new_byte = base[offset + block_size];
+            checksum.a          = static_cast<uint16_t>(checksum.a - old_byte + new_byte);
+            checksum.b          = static_cast<uint16_t>(checksum.b - block_size * old_byte + checksum.a);
+            offset++;
+        }
+    }
+    return res;
+}
+
+struct ByteRange {
+    uint64_t begin{};
+    uint64_t end{}; // Exclusive
+};
+
+static auto missing_ranges(ZsyncControlFile const& control_file, std::vector<std::optional<uint64_t>> const& known_blocks) -> std::vector<ByteRange>
+{
+    auto res = std::vector<ByteRange>{};
+    for (size_t i = 0; i < known_blocks.size(); ++i)
+    {
+        if (known_blocks[i].has_value())
+            continue;
+        auto const begin = i * control_file.block_size;
+        auto const end   = std::min<uint64_t>(begin + control_file.block_size, control_file.length);
+        if (!res.empty() && res.back().end == begin)
+            res.back().end = end;
+        else
+            res.push_back({begin, end});
+    }
+    return res;
+}
+
+/// Merges the ranges that are the closest to each other, until there are no more than `max_nb_of_ranges`.
+/// We will re-download a few bytes that we already had, but each request has a cost, so we don't want to send thousands of them.
+static auto merge_ranges(std::vector<ByteRange> const& ranges, size_t max_nb_of_ranges) -> std::vector<ByteRange>
+{
+    if (ranges.size() <= max_nb_of_ranges)
+        return ranges;
+
+    auto gaps = std::vector<uint64_t>{};
+    for (size_t i = 0; i + 1 < ranges.size(); ++i)
+        gaps.push_back(ranges[i + 1].begin - ranges[i].end);
+    auto const nb_gaps_to_close = ranges.size() - max_nb_of_ranges;
+    std::nth_element(gaps.begin(), gaps.begin() + static_cast<std::ptrdiff_t>(nb_gaps_to_close - 1), gaps.end());
+    auto const max_gap_to_close = gaps[nb_gaps_to_close - 1];
+
+    auto res = std::vector<ByteRange>{ranges[0]};
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        if (ranges[i].begin - res.back().end <= max_gap_to_close)
+            res.back().end = ranges[i].end;
+        else
+            res.push_back(ranges[i]);
+    }
+    return res;
+}
+
+static auto fetch_control_file(std::string const& zsync_url, std::function<bool()> const& wants_to_cancel) -> tl::expected<ZsyncControlFile, std::string>
+{
+    auto const res = make_http_request(zsync_url, [&](uint64_t, uint64_t) {
+        return !wants_to_cancel();
+    });
+    if (!res || res->status != 200)
+        return tl::make_unexpected("Failed to download the zsync control file"s);
+
+    auto control_file = parse_zsync_control_file(res->body);
+    if (!control_file)
+        return tl::make_unexpected("Invalid zsync control file"s);
+    return std::move(*control_file);
+}
+
+static auto download_range(std::string const& url, ByteRange range, std::fstream& file, std::function<void(uint64_t)> const& on_bytes_received, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<void, std::string>
+{
+    file.seekp(static_cast<std::streamoff>(range.begin));
+
+    auto       bytes_received     = uint64_t{0};
+    auto       is_partial_content = false;
+    auto const res                = make_http_request(
+        url, httplib::Headers{{"Range", fmt::format("bytes={}-{}", range.begin, range.end - 1)}},
+        [&](httplib::Response const& response) {
+            is_partial_content = response.status == 206;
+            return is_partial_content; // Otherwise the server is about to send us the whole file
+        },
+        [&](char const* data, size_t length) {
+            auto const size = std::min<uint64_t>(length, range.end - range.begin - bytes_received);
+            file.write(data, static_cast<std::streamsize>(size));
+            bytes_received += size;
+            on_bytes_received(size);
+            return file.good() && !wants_to_cancel();
+        },
+        [&](uint64_t, uint64_t) {
+            return !wants_to_cancel();
+        }
+    );
+    if (!res || !is_partial_content || bytes_received != range.end - range.begin)
+        return tl::make_unexpected(fmt::format("Failed to download bytes {} to {}", range.begin, range.end));
+    if (!file.good())
+        return tl::make_unexpected("Failed to write the downloaded bytes"s);
+    return {};
+}
+
+auto download_with_delta(std::string const& zsync_url, std::string const& url, std::filesystem::path const& base_file, std::filesystem::path const& destination, std::function<void(uint64_t)> const& throttle, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<uint64_t, std::string>
+{
+    auto const control_file = fetch_control_file(zsync_url, wants_to_cancel);
+    if (!control_file)
+        return tl::make_unexpected(control_file.error());
+
+    auto const base = MappedFile{base_file};
+    if (!base.is_open())
+        return tl::make_unexpected(fmt::format("Failed to open \"{}\"", base_file));
+
+    auto const known_blocks = find_known_blocks(
+        *control_file, std::span{reinterpret_cast<uint8_t const*>(base.data()), base.size()}, // NOLINT(*reinterpret-cast)
+        [&](float progress) { set_progress(progress * 0.2f); },
+        wants_to_cancel
+    );
+    if (wants_to_cancel())
+        return tl::make_unexpected("Cancelled"s);
+    if (std::none_of(known_blocks.begin(), known_blocks.end(), [](auto const& offset) { return offset.has_value(); }))
+        return tl::make_unexpected("The base file has nothing in common with the new one"s); // A regular download will be faster, and can be resumed
+
+    // Start with the blocks we already have
+    if (!Cool::File::create_folders_for_file_if_they_dont_exist(destination))
+        return tl::make_unexpected(fmt::format("Failed to create the folder of \"{}\"", destination));
+    {
+        auto const file = std::ofstream{destination, std::ios::binary | std::ios::trunc};
+    }
+    auto error_code = std::error_code{};
+    std::filesystem::resize_file(destination, control_file->length, error_code);
+    if (error_code)
+        return tl::make_unexpected(fmt::format("Failed to allocate \"{}\": {}", destination, error_code.message()));
+
+    auto file = std::fstream{destination, std::ios::binary | std::ios::in | std::ios::out};
+    for (size_t i = 0; i < known_blocks.size(); ++i)
+    {
+        if (!known_blocks[i].has_value())
+            continue;
+        auto const begin = i * control_file->block_size;
+        auto const size  = std::min<uint64_t>(control_file->block_size, control_file->length - begin);
+        file.seekp(static_cast<std::streamoff>(begin));
+        file.write(base.data() + *known_blocks[i], static_cast<std::streamsize>(size)); // NOLINT(*pointer-arithmetic)
+    }
+    if (!file.good())
+        return tl::make_unexpected(fmt::format("Failed to write to \"{}\"", destination));
+
+    // Then download the ones that changed
+    auto const ranges            = merge_ranges(missing_ranges(*control_file, known_blocks), max_nb_of_requests);
+    auto       bytes_to_download = uint64_t{0};
+    for (auto const& range : ranges)
+        bytes_to_download += range.end - range.begin;
+
+    auto bytes_downloaded = uint64_t{0};
+    for (auto const& range : ranges)
+    {
+        auto const success = download_range(
+            url, range, file,
+            [&](uint64_t nb_bytes) {
+                bytes_downloaded += nb_bytes;
+                set_progress(0.2f + 0.8f * static_cast<float>(bytes_downloaded) / static_cast<float>(bytes_to_download));
+                if (throttle)
+                    throttle(nb_bytes);
+            },
+            wants_to_cancel
+        );
+        if (!success)
+            return tl::make_unexpected(success.error());
+    }
+    file.close();
+
+    // Make sure we rebuilt the file correctly
+    auto const sha1 = sha1_of_file(destination);
+    if (!sha1 || *sha1 != control_file->sha1)
+        return tl::make_unexpected("The file we rebuilt doesn't match its SHA-1"s);
+    return bytes_downloaded;
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include <random>
+#include "Testing/LocalFileServer.hpp"
+#include "doctest/doctest.h"
+
+/// Does the same as the zsyncmake tool that generates the control files published next to the releases
+static auto make_zsync_control_file(std::string const& content, size_t block_size, std::string const& sha1, size_t seq_matches, size_t rsum_bytes, size_t checksum_bytes) -> std::string
+{
+    auto res = fmt::format("zsync: 0.6.2\nFilename: Coollab.AppImage\nBlocksize: {}\nLength: {}\nHash-Lengths: {},{},{}\nSHA-1: {}\n\n", block_size, content.size(), seq_matches, rsum_bytes, checksum_bytes, sha1);
+    for (size_t begin = 0; begin < content.size(); begin += block_size)
+    {
+        auto block = content.substr(begin, block_size);
+        block.resize(block_size, '\0'); // The last block is padded with zeros
+        auto const* const data     = reinterpret_cast<uint8_t const*>(block.data()); // NOLINT(*reinterpret-cast)
+        auto const        checksum = rolling_checksum(data, block_size);
+        auto const        rsum     = std::array<char, 4>{static_cast<char>(checksum.a >> 8), static_cast<char>(checksum.a & 0xFF), static_cast<char>(checksum.b >> 8), static_cast<char>(checksum.b & 0xFF)};
+        res.append(rsum.end() - static_cast<std::ptrdiff_t>(rsum_bytes), rsum.end());
+        auto const md4_of_block = md4(data, block_size);
+        res.append(md4_of_block.begin(), md4_of_block.begin() + static_cast<std::ptrdiff_t>(checksum_bytes));
+    }
+    return res;
+}
+
+static auto random_content(size_t size, unsigned seed) -> std::string
+{
+    auto generator = std::mt19937{seed};
+    auto res       = std::string(size, '\0');
+    for (auto& c : res)
+        c = static_cast<char>(generator());
+    return res;
+}
+
+/// An older version, and a newer one with some bytes inserted, removed and modified
+static auto old_and_new_versions() -> std::pair<std::string, std::string>
+{
+    auto const old_version = random_content(200'000, 1);
+    auto       new_version = old_version.substr(0, 50'000) + random_content(3'000, 2) + old_version.substr(50'000, 100'000) + old_version.substr(160'000);
+    new_version[190'000] ^= 1;
+    return {old_version, new_version};
+}
+
+TEST_CASE("Finding the blocks that an old version has in common with a new one")
+{
+    static constexpr size_t block_size{1024};
+    auto const [old_version, new_version] = old_and_new_versions();
+
+    for (auto const& hash_lengths : {std::array<size_t, 3>{1, 4, 16}, std::array<size_t, 3>{2, 2, 5}})
+    {
+        auto const control_file = parse_zsync_control_file(make_zsync_control_file(new_version, block_size, "unused", hash_lengths[0], hash_lengths[1], hash_lengths[2]));
+        REQUIRE(control_file.has_value());
+        auto const known_blocks = find_known_blocks(*control_file, std::span{reinterpret_cast<uint8_t const*>(old_version.data()), old_version.size()}, [](float) {}, []() { return false; }); // NOLINT(*reinterpret-cast)
+
+        // Rebuild the new version, using the old one for the blocks we found, and the new one for the missing blocks (which is what we would download)
+        auto rebuilt  = std::string{};
+        auto nb_found = size_t{0};
+        for (size_t i = 0; i < known_blocks.size(); ++i)
+        {
+            auto const size = std::min(block_size, new_version.size() - i * block_size);
+            rebuilt += known_blocks[i] ? old_version.substr(*known_blocks[i], size) : new_version.substr(i * block_size, size);
+            nb_found += known_blocks[i] ? 1u : 0u;
+        }
+        CHECK(rebuilt == new_version);
+        CHECK(nb_found > known_blocks.size() * 9 / 10);
+    }
+}
+
+TEST_CASE("Merging the ranges to download")
+{
+    auto const ranges = merge_ranges({{0, 10}, {20, 30}, {100, 110}, {115, 120}}, 2);
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].begin == 0);
+    CHECK(ranges[0].end == 30);
+    CHECK(ranges[1].begin == 100);
+    CHECK(ranges[1].end == 120);
+}
+
+TEST_CASE("Downloading a new version with a delta")
+{
+    auto const [old_version, new_version] = old_and_new_versions();
+    auto const folder                     = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "delta";
+    Cool::File::remove_folder(folder);
+    Cool::File::set_content(folder / "old.AppImage", old_version);
+    Cool::File::set_content(folder / "new.AppImage", new_version);
+
+    auto const file_server  = LocalFileServer{new_version};
+    auto const zsync_server = LocalFileServer{make_zsync_control_file(new_version, 1024, *sha1_of_file(folder / "new.AppImage"), 2, 2, 5)};
+
+    auto       throttled_bytes = uint64_t{0};
+    auto const res             = download_with_delta(zsync_server.url(), file_server.url(), folder / "old.AppImage", folder / "rebuilt.AppImage", [&](uint64_t nb_bytes) { throttled_bytes += nb_bytes; }, [](float) {}, []() { return false; });
+    REQUIRE(res.has_value());
+    CHECK(*res < new_version.size() / 10);
+    CHECK(throttled_bytes == *res);
+    CHECK(sha1_of_file(folder / "rebuilt.AppImage") == sha1_of_file(folder / "new.AppImage"));
+    Cool::File::remove_folder(folder);
+}
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include "tl/expected.hpp"
+
+/// Builds the file at `url` into `destination` by reusing the blocks it has in common with `base_file` (typically the same asset from an older version), and only downloading the blocks that changed.
+/// This requires a zsync control file (see http://zsync.moria.org.uk/) describing the new file, available at `zsync_url`.
+/// Returns the number of bytes that had to be downloaded.
+/// Errors are only meant to be logged: the caller should fall back to a regular download.
+/// If set, `throttle` is called after each chunk we receive, and can block to slow down the download (same as DownloadOptions::throttle).
+auto download_with_delta(std::string const& zsync_url, std::string const& url, std::filesystem::path const& base_file, std::filesystem::path const& destination, std::function<void(uint64_t nb_bytes)> const& throttle, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<uint64_t, std::string>;
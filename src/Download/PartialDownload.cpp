@@ -0,0 +1,66 @@
+#include "PartialDownload.hpp"
+#include <fstream>
+#include "Cool/File/File.h"
+#include "Cool/Serialization/Json.hpp"
+#include "nlohmann/json.hpp"
+
+auto PartialDownload::bytes_received() const -> uint64_t
+{
+    auto res = uint64_t{0};
+    for (auto const& segment : segments)
+        res += segment.bytes_received;
+    return res;
+}
+
+static auto journal_path(std::filesystem::path const& destination) -> std::filesystem::path
+{
+    return destination.string() + ".journal.json";
+}
+
+auto load_partial_download(std::filesystem::path const& destination) -> std::optional<PartialDownload>
+{
+    auto file = std::ifstream{journal_path(destination)};
+    if (!file.is_open())
+        return std::nullopt;
+
+    try
+    {
+        auto const json    = nlohmann::json::parse(file);
+        auto       partial = PartialDownload{};
+        Cool::json_get(json, "URL", partial.url);
+        Cool::json_get(json, "Validator", partial.validator);
+        Cool::json_get(json, "Total size", partial.total_size);
+        for (auto const& segment : json.at("Segments"))
+        {
+            partial.segments.push_back(PartialDownload::Segment{
+                .begin          = segment.at(0).get<uint64_t>(),
+                .end            = segment.at(1).get<uint64_t>(),
+                .bytes_received = segment.at(2).get<uint64_t>(),
+            });
+        }
+        return partial;
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Load partial download", e.what());
+        return std::nullopt;
+    }
+}
+
+void save_partial_download(std::filesystem::path const& destination, PartialDownload const& partial)
+{
+    auto json = nlohmann::json{};
+    Cool::json_set(json, "URL", partial.url);
+    Cool::json_set(json, "Validator", partial.validator);
+    Cool::json_set(json, "Total size", partial.total_size);
+    auto segments = nlohmann::json::array();
+    for (auto const& segment : partial.segments)
+        segments.push_back({segment.begin, segment.end, segment.bytes_received});
+    json["Segments"] = std::move(segments);
+    Cool::File::set_content(journal_path(destination), json.dump());
+}
+
+void remove_partial_download_journal(std::filesystem::path const& destination)
+{
+    Cool::File::remove_file(journal_path(destination));
+}
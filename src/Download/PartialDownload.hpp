@@ -0,0 +1,21 @@
+#pragma once
+
+/// Journal saved next to a file while it is being downloaded, so that if the download gets interrupted we can resume it instead of starting again from scratch
+struct PartialDownload {
+    struct Segment {
+        uint64_t begin{};
+        uint64_t end{}; // Exclusive. 0 if we don't know the size of the file
+        uint64_t bytes_received{};
+    };
+
+    std::string          url{};
+    std::string          validator{}; // ETag, or Last-Modified if the server didn't send an ETag. Allows the server to tell us if the file has changed since we started downloading it, in which case we can't resume
+    uint64_t             total_size{}; // 0 if we don't know the size of the file
+    std::vector<Segment> segments{};   // When downloading sequentially there is only one segment, otherwise each of them is downloaded in parallel with the others
+
+    auto bytes_received() const -> uint64_t;
+};
+
+auto load_partial_download(std::filesystem::path const& destination) -> std::optional<PartialDownload>;
+void save_partial_download(std::filesystem::path const& destination, PartialDownload const&);
+void remove_partial_download_journal(std::filesystem::path const& destination);
@@ -0,0 +1,588 @@
+#include "download_file.hpp"
+#include <atomic>
+#include <fstream>
+#include <future>
+#include "Cool/File/File.h"
+#include "Hash/Sha256.hpp"
+#include "PartialDownload.hpp"
+#include "make_http_request.hpp"
+#include "suggest_dl_from_github.hpp"
+
+static constexpr uint64_t bytes_between_journal_saves{8'000'000};
+static constexpr uint64_t bytes_between_availability_notifications{1'000'000}; // Each notification requires to flush the file, so we don't want to do it for every chunk we receive
+static constexpr uint64_t min_segment_size{1'000'000}; // Below that, the cost of opening a new connection is not worth it
+static constexpr int      max_nb_of_attempts{5};
+
+/// Ordered from least to most severe
+enum class DownloadOutcome : uint8_t {
+    Completed,
+    Canceled,
+    ConnectionLost,
+    FileChangedOnServer, // Our partial download is outdated and needs to start again from scratch
+    ServerError,
+    WriteError,
+};
+
+static auto file_error(std::filesystem::path const& destination) -> tl::unexpected<std::string>
+{
+    return tl::make_unexpected(fmt::format("Make sure you have the permission to write files in the folder \"{}\", and that there is enough space left on your disk", destination.parent_path()));
+}
+
+static auto validator(httplib::Response const& response) -> std::string
+{
+    if (response.has_header("ETag"))
+        return response.get_header_value("ETag");
+    return response.get_header_value("Last-Modified"); // Empty if there is no such header, in which case we won't be able to resume the download
+}
+
+/// Returns what we have already downloaded in a previous attempt and that we can keep, if anything
+static auto resumable_partial_download(std::string const& url, std::filesystem::path const& destination) -> std::optional<PartialDownload>
+{
+    auto partial = load_partial_download(destination);
+    if (!partial || partial->url != url || partial->validator.empty() || partial->segments.empty())
+        return std::nullopt;
+    if (!Cool::File::exists(destination))
+        return std::nullopt;
+    return partial;
+}
+
+/// Hashes the file from its beginning, as it gets downloaded, so that the hash is ready as soon as the download completes
+class IncrementalFileHash {
+public:
+    explicit IncrementalFileHash(std::filesystem::path path)
+        : _path{std::move(path)}
+    {}
+
+    /// For the bytes that come right after the ones that have already been hashed, as we receive them
+    void update(char const* data, size_t size)
+    {
+        _sha256->update(data, size);
+        _nb_bytes_hashed += size;
+    }
+
+    /// Hashes the first `nb_bytes` of the file, reading from the disk the ones that haven't been hashed yet (e.g. because they were downloaded by a previous attempt, or by another segment)
+    auto update_from_disk(uint64_t nb_bytes) -> bool
+    {
+        if (nb_bytes <= _nb_bytes_hashed)
+            return true;
+
+        auto file = std::ifstream{_path, std::ios::binary};
+        if (!file.is_open())
+            return false;
+        file.seekg(static_cast<std::streamoff>(_nb_bytes_hashed));
+        auto buffer = std::vector<char>(1'000'000);
+        while (_nb_bytes_hashed < nb_bytes)
+        {
+            auto const size = std::min<uint64_t>(buffer.size(), nb_bytes - _nb_bytes_hashed);
+            if (!file.read(buffer.data(), static_cast<std::streamsize>(size)))
+                return false;
+            update(buffer.data(), size);
+        }
+        return true;
+    }
+
+    /// When the download starts again from scratch
+    void restart()
+    {
+        _sha256.emplace();
+        _nb_bytes_hashed = 0;
+    }
+
+    auto finalize() -> std::string { return _sha256->finalize(); }
+
+private:
+    std::filesystem::path _path;
+    std::optional<Sha256> _sha256{std::in_place};
+    uint64_t              _nb_bytes_hashed{0};
+};
+
+struct RemoteFileInfo {
+    uint64_t    size{};
+    bool        accepts_ranges{};
+    std::string validator{};
+};
+
+static auto fetch_remote_file_info(std::string const& url) -> std::optional<RemoteFileInfo>
+{
+    auto const res = make_http_head_request(url);
+    if (!res || res->status != 200)
+        return std::nullopt;
+
+    try
+    {
+        return RemoteFileInfo{
+            .size           = std::stoull(res->get_header_value("Content-Length")),
+            .accepts_ranges = res->get_header_value("Accept-Ranges") == "bytes",
+            .validator      = validator(*res),
+        };
+    }
+    catch (...) // The server didn't tell us the size of the file
+    {
+        return std::nullopt;
+    }
+}
+
+/* ---------------------------------------------------------------------------------------------------------------------------------- */
+/* Sequential download, when the server doesn't support Range requests or when the file is small                                     */
+/* ---------------------------------------------------------------------------------------------------------------------------------- */
+
+static auto download_sequentially(std::string const& url, std::filesystem::path const& destination, std::function<void(uint64_t)> const& on_bytes_available, std::function<void(uint64_t)> const& throttle, IncrementalFileHash& hash, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> DownloadOutcome
+{
+    auto const notify_bytes_available = [&](uint64_t nb_bytes) {
+        if (on_bytes_available)
+            on_bytes_available(nb_bytes);
+    };
+
+    auto partial = resumable_partial_download(url, destination);
+    if (partial && partial->segments.size() != 1) // This partial download was made by download_in_segments(), we can't resume it sequentially
+        partial.reset();
+
+    auto error_code = std::error_code{};
+    // If we crashed, the file might contain a few bytes more than what the journal says, but we can't trust them because we don't know if they were fully written
+    auto const resume_from = partial ? std::min<uint64_t>(partial->segments[0].bytes_received, std::filesystem::file_size(destination, error_code)) : 0;
+    if (resume_from == 0 || error_code)
+        partial.reset();
+    std::filesystem::resize_file(destination, partial ? resume_from : 0, error_code); // No-op if the file doesn't exist yet
+    hash.restart();
+    if (partial && !hash.update_from_disk(resume_from)) // What we downloaded in a previous attempt
+        return DownloadOutcome::WriteError;
+
+    auto file = std::ofstream{destination, std::ios::binary | (partial ? std::ios::app : std::ios::trunc)};
+    if (!file.is_open())
+        return DownloadOutcome::WriteError;
+    notify_bytes_available(partial ? resume_from : 0);
+
+    auto headers = httplib::Headers{};
+    if (partial)
+    {
+        headers.emplace("Range", fmt::format("bytes={}-", resume_from));
+        headers.emplace("If-Range", partial->validator); // If the file has changed on the server since our previous attempt, it will send us the whole new file instead of the range
+    }
+
+    auto  journal        = PartialDownload{.url = url, .segments = {PartialDownload::Segment{}}};
+    auto& bytes_received = journal.segments[0].bytes_received;
+
+    bool     has_failed_to_write{false};
+    bool     has_started_receiving{false};
+    uint64_t offset{partial ? resume_from : 0}; // Position, in the whole file, of the first byte of the content we are receiving
+    auto     last_journal_save = uint64_t{0};
+    auto     last_notification = uint64_t{0};
+    auto const res             = make_http_request(
+        url, headers,
+        [&](httplib::Response const& response) {
+            if (response.status != 200 && response.status != 206)
+                return true; // Don't touch the journal, the error might be temporary and we will want to resume later
+            if (response.status == 200 && offset != 0)
+            {
+                // The server ignored our Range request (because the file has changed, or because it doesn't support it), so we restart from the beginning
+                offset = 0;
+                file.close();
+                file.open(destination, std::ios::binary | std::ios::trunc);
+                if (!file.is_open())
+                {
+                    has_failed_to_write = true;
+                    return false;
+                }
+                hash.restart();
+                notify_bytes_available(0);
+            }
+            has_started_receiving = true;
+            journal.validator     = validator(response);
+            bytes_received        = offset;
+            save_partial_download(destination, journal);
+            last_journal_save = offset;
+            return true;
+        },
+        [&](char const* data, size_t length) {
+            file.write(data, static_cast<std::streamsize>(length));
+            if (!file)
+            {
+                has_failed_to_write = true;
+                return false;
+            }
+            hash.update(data, length);
+            bytes_received += length;
+            if (bytes_received - last_journal_save > bytes_between_journal_saves)
+            {
+                file.flush(); // Make sure the bytes are on disk before the journal says they are
+                save_partial_download(destination, journal);
+                last_journal_save = bytes_received;
+            }
+            if (on_bytes_available && bytes_received - last_notification > bytes_between_availability_notifications)
+            {
+                file.flush();
+                notify_bytes_available(bytes_received);
+                last_notification = bytes_received;
+            }
+            if (throttle)
+                throttle(length);
+            return !wants_to_cancel();
+        },
+        [&](uint64_t current, uint64_t total) {
+            if (total != 0) // Happens when the server doesn't tell us the size of the file
+                set_progress(static_cast<float>(offset + current) / static_cast<float>(offset + total));
+            return !wants_to_cancel();
+        }
+    );
+    file.close();
+    if (has_started_receiving && !has_failed_to_write && !file.fail())
+    {
+        save_partial_download(destination, journal); // Even if we got cancelled or lost the connection, so that we can resume next time
+        notify_bytes_available(bytes_received);
+    }
+
+    if (wants_to_cancel())
+        return DownloadOutcome::Canceled;
+    if (has_failed_to_write || file.fail())
+        return DownloadOutcome::WriteError;
+    if (!res)
+        return DownloadOutcome::ConnectionLost;
+    if (res->status == 416) // Range Not Satisfiable: our journal is out of sync with the file on the server
+        return DownloadOutcome::FileChangedOnServer;
+    if (res->status != 200 && res->status != 206)
+        return DownloadOutcome::ServerError;
+    return DownloadOutcome::Completed;
+}
+
+/* ---------------------------------------------------------------------------------------------------------------------------------- */
+/* Segmented download: several ranges of the file are downloaded in parallel, each on its own thread and connection                   */
+/* ---------------------------------------------------------------------------------------------------------------------------------- */
+
+struct SegmentState {
+    uint64_t              begin{};
+    uint64_t              end{}; // Exclusive
+    std::atomic<uint64_t> bytes_received{};
+    std::atomic<uint64_t> bytes_on_disk{}; // Bytes that have been flushed to the disk. This is what we can safely write in the journal
+};
+
+static auto download_segment(std::string const& url, std::filesystem::path const& destination, std::string const& validator, SegmentState& segment, std::function<void(uint64_t)> const& throttle, std::atomic<bool> const& cancel)
+    -> DownloadOutcome
+{
+    auto const start = segment.begin + segment.bytes_received.load();
+    if (start >= segment.end)
+        return DownloadOutcome::Completed;
+
+    auto file = std::fstream{destination, std::ios::binary | std::ios::in | std::ios::out}; // Don't truncate, the file has been preallocated and the other segments are writing in it at the same time
+    if (!file.is_open())
+        return DownloadOutcome::WriteError;
+    file.seekp(static_cast<std::streamoff>(start));
+
+    bool       has_failed_to_write{false};
+    bool       file_has_changed{false};
+    auto const res = make_http_request(
+        url,
+        httplib::Headers{
+            {"Range", fmt::format("bytes={}-{}", start, segment.end - 1)},
+            {"If-Range", validator},
+        },
+        [&](httplib::Response const& response) {
+            if (response.status == 200) // The server sent us the whole file instead of the range we asked for, which means that the file has changed since we started downloading it
+            {
+                file_has_changed = true;
+                return false;
+            }
+            return true;
+        },
+        [&](char const* data, size_t length) {
+            auto const remaining = segment.end - segment.begin - segment.bytes_received.load();
+            auto const nb_bytes  = std::min<uint64_t>(length, remaining); // Just in case the server sends us more than what we asked for, don't overwrite the next segment
+            file.write(data, static_cast<std::streamsize>(nb_bytes));
+            if (!file)
+            {
+                has_failed_to_write = true;
+                return false;
+            }
+            auto const bytes_received = segment.bytes_received.fetch_add(nb_bytes) + nb_bytes;
+            if (bytes_received - segment.bytes_on_disk.load() > bytes_between_journal_saves)
+            {
+                file.flush();
+                segment.bytes_on_disk.store(bytes_received);
+            }
+            if (throttle)
+                throttle(nb_bytes);
+            return !cancel.load();
+        },
+        [&](uint64_t, uint64_t) {
+            return !cancel.load();
+        }
+    );
+    file.close();
+    if (!has_failed_to_write && !file.fail())
+        segment.bytes_on_disk.store(segment.bytes_received.load());
+
+    if (cancel.load())
+        return DownloadOutcome::Canceled;
+    if (file_has_changed)
+        return DownloadOutcome::FileChangedOnServer;
+    if (has_failed_to_write || file.fail())
+        return DownloadOutcome::WriteError;
+    if (!res)
+        return DownloadOutcome::ConnectionLost;
+    if (res->status == 416)
+        return DownloadOutcome::FileChangedOnServer;
+    if (res->status != 206)
+        return DownloadOutcome::ServerError;
+    if (segment.begin + segment.bytes_received.load() < segment.end)
+        return DownloadOutcome::ConnectionLost; // The server closed the connection before sending the whole range
+    return DownloadOutcome::Completed;
+}
+
+static auto split_in_segments(uint64_t size, size_t max_nb_of_segments) -> std::vector<PartialDownload::Segment>
+{
+    auto const nb_segments  = std::clamp<uint64_t>(size / min_segment_size, 1, max_nb_of_segments);
+    auto const segment_size = size / nb_segments;
+
+    auto segments = std::vector<PartialDownload::Segment>{};
+    for (uint64_t i = 0; i < nb_segments; ++i)
+    {
+        segments.push_back(PartialDownload::Segment{
+            .begin = i * segment_size,
+            .end   = i == nb_segments - 1 ? size : (i + 1) * segment_size, // The last segment also takes the remainder of the division
+        });
+    }
+    return segments;
+}
+
+/// The number of bytes at the beginning of the file that have all been written to disk
+static auto contiguous_bytes_on_disk(std::vector<SegmentState> const& segments) -> uint64_t
+{
+    auto res = uint64_t{0};
+    for (auto const& segment : segments)
+    {
+        auto const bytes_on_disk = segment.bytes_on_disk.load();
+        res                      = segment.begin + bytes_on_disk;
+        if (segment.begin + bytes_on_disk < segment.end)
+            break;
+    }
+    return res;
+}
+
+static auto download_in_segments(std::string const& url, std::filesystem::path const& destination, RemoteFileInfo const& remote, size_t max_nb_of_segments, std::function<void(uint64_t)> const& throttle, IncrementalFileHash& hash, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> DownloadOutcome
+{
+    hash.restart();
+    auto journal = resumable_partial_download(url, destination);
+    if (!journal || journal->validator != remote.validator || journal->total_size != remote.size)
+    {
+        journal = PartialDownload{
+            .url        = url,
+            .validator  = remote.validator,
+            .total_size = remote.size,
+            .segments   = split_in_segments(remote.size, max_nb_of_segments),
+        };
+        {
+            auto file = std::ofstream{destination, std::ios::binary | std::ios::trunc};
+            if (!file.is_open())
+                return DownloadOutcome::WriteError;
+        }
+        auto error_code = std::error_code{};
+        std::filesystem::resize_file(destination, remote.size, error_code); // Preallocate the file, so that each segment can write at its position
+        if (error_code)
+            return DownloadOutcome::WriteError;
+        save_partial_download(destination, *journal);
+    }
+
+    auto segments = std::vector<SegmentState>(journal->segments.size());
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        segments[i].begin = journal->segments[i].begin;
+        segments[i].end   = journal->segments[i].end;
+        segments[i].bytes_received.store(journal->segments[i].bytes_received);
+        segments[i].bytes_on_disk.store(journal->segments[i].bytes_received);
+    }
+
+    auto const save_journal = [&]() {
+        for (size_t i = 0; i < segments.size(); ++i)
+            journal->segments[i].bytes_received = segments[i].bytes_on_disk.load();
+        save_partial_download(destination, *journal);
+    };
+
+    auto cancel   = std::atomic<bool>{false};
+    auto outcomes = std::vector<std::future<DownloadOutcome>>{};
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        outcomes.push_back(std::async(std::launch::async, [&, i]() {
+            return download_segment(url, destination, journal->validator, segments[i], throttle, cancel);
+        }));
+    }
+
+    // While the segments are downloading, this thread takes care of reporting the progress, forwarding cancellation requests, and saving the journal
+    auto last_journal_save = std::chrono::steady_clock::now();
+    for (auto& outcome : outcomes)
+    {
+        while (outcome.wait_for(100ms) != std::future_status::ready)
+        {
+            if (wants_to_cancel())
+                cancel.store(true);
+
+            auto bytes_received = uint64_t{0};
+            for (auto const& segment : segments)
+                bytes_received += segment.bytes_received.load();
+            set_progress(static_cast<float>(bytes_received) / static_cast<float>(remote.size));
+
+            // The segments arrive out of order, so we hash the beginning of the file as it fills up. It was just written, so reading it back is cheap because it is still in the OS cache
+            std::ignore = hash.update_from_disk(contiguous_bytes_on_disk(segments)); // If it fails we will try again, and the end of the download will report the error
+
+            if (std::chrono::steady_clock::now() - last_journal_save > 1s)
+            {
+                save_journal();
+                last_journal_save = std::chrono::steady_clock::now();
+            }
+        }
+    }
+    save_journal();
+
+    auto res = DownloadOutcome::Completed;
+    for (auto& outcome : outcomes)
+        res = std::max(res, outcome.get());
+    return res;
+}
+
+/* ---------------------------------------------------------------------------------------------------------------------------------- */
+
+auto download_file(std::string const& url, std::filesystem::path const& destination, DownloadOptions const& options, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<std::string, std::string>
+{
+    if (!Cool::File::create_folders_for_file_if_they_dont_exist(destination))
+        return file_error(destination);
+
+    for (int attempt = 1;; ++attempt)
+    {
+        auto const bytes_received_before = resumable_partial_download(url, destination).value_or(PartialDownload{}).bytes_received();
+        auto       hash                  = IncrementalFileHash{destination};
+
+        auto const remote  = options.max_nb_of_segments > 1 && !options.on_bytes_available ? fetch_remote_file_info(url) : std::nullopt;
+        auto const outcome = remote && remote->accepts_ranges && !remote->validator.empty() && remote->size >= 2 * min_segment_size
+                                 ? download_in_segments(url, destination, *remote, options.max_nb_of_segments, options.throttle, hash, set_progress, wants_to_cancel)
+                                 : download_sequentially(url, destination, options.on_bytes_available, options.throttle, hash, set_progress, wants_to_cancel);
+
+        switch (outcome)
+        {
+        case DownloadOutcome::Completed:
+        {
+            remove_partial_download_journal(destination); // The file is complete, there is nothing left to resume
+            auto       error_code = std::error_code{};
+            auto const size       = std::filesystem::file_size(destination, error_code);
+            if (error_code || !hash.update_from_disk(size)) // Only the end of the segmented downloads is left to hash
+                return file_error(destination);
+            auto sha256 = hash.finalize();
+            if (options.expected_sha256.has_value() && *options.expected_sha256 != sha256)
+            {
+                remove_download(destination); // So that the next attempt starts from scratch
+                return tl::make_unexpected("The downloaded file is corrupted, please try again.\n\n" + suggest_dl_from_github());
+            }
+            return sha256;
+        }
+        case DownloadOutcome::Canceled:
+        {
+            return ""s;
+        }
+        case DownloadOutcome::ConnectionLost:
+        {
+            // If we lost the connection in the middle of the download, try again from where we stopped
+            // But if we didn't manage to download anything, we probably don't have an Internet connection at all, so there is no point in retrying
+            auto const bytes_received_after = resumable_partial_download(url, destination).value_or(PartialDownload{}).bytes_received();
+            if (attempt < max_nb_of_attempts && bytes_received_after > bytes_received_before)
+                continue;
+            return tl::make_unexpected("No Internet connection.\n\n" + suggest_dl_from_github());
+        }
+        case DownloadOutcome::FileChangedOnServer:
+        {
+            remove_partial_download_journal(destination);
+            if (attempt < max_nb_of_attempts)
+                continue;
+            return tl::make_unexpected("Oops, our online versions provider is unavailable, please check back later.\n\n" + suggest_dl_from_github());
+        }
+        case DownloadOutcome::ServerError:
+        {
+            return tl::make_unexpected("Oops, our online versions provider is unavailable, please check back later.\n\n" + suggest_dl_from_github());
+        }
+        case DownloadOutcome::WriteError:
+        {
+            return file_error(destination);
+        }
+        }
+    }
+}
+
+void remove_download_unless_it_can_be_resumed(std::filesystem::path const& destination)
+{
+    if (load_partial_download(destination).has_value())
+        return;
+    Cool::File::remove_file(destination);
+}
+
+void remove_download(std::filesystem::path const& destination)
+{
+    remove_partial_download_journal(destination);
+    Cool::File::remove_file(destination);
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include <random>
+#include "Testing/LocalFileServer.hpp"
+#include "doctest/doctest.h"
+
+static auto random_content(size_t size) -> std::string
+{
+    auto generator = std::mt19937{42};
+    auto res       = std::string(size, '\0');
+    for (auto& c : res)
+        c = static_cast<char>(generator());
+    return res;
+}
+
+static auto read_file(std::filesystem::path const& path) -> std::string
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Downloading a file, sequentially and in segments")
+{
+    auto const content     = random_content(5'000'123);
+    auto const server      = LocalFileServer{content};
+    auto const destination = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "download";
+
+    for (size_t const nb_segments : std::array<size_t, 2>{1, 4})
+    {
+        remove_download(destination);
+        auto const res = download_file(server.url(), destination, {.max_nb_of_segments = nb_segments}, [](float) {}, []() { return false; });
+        REQUIRE(res.has_value());
+        CHECK(read_file(destination) == content);
+        CHECK(*res == sha256_of_file(destination));
+    }
+    remove_download(destination);
+}
+
+TEST_CASE("A download that doesn't match its expected SHA-256 fails")
+{
+    auto const content     = random_content(3'000'000);
+    auto const server      = LocalFileServer{content};
+    auto const destination = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "download_corrupted";
+
+    remove_download(destination);
+    auto const res = download_file(server.url(), destination, {.expected_sha256 = "0000"}, [](float) {}, []() { return false; });
+    CHECK(!res.has_value());
+    CHECK(!Cool::File::exists(destination));
+}
+
+TEST_CASE("Benchmark: download throughput depending on the number of segments" * doctest::skip()) // Run it manually with --no-skip
+{
+    auto const content     = random_content(300'000'000);
+    auto const server      = LocalFileServer{content};
+    auto const destination = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "download_benchmark";
+
+    for (size_t const nb_segments : std::array<size_t, 5>{1, 2, 4, 8, 16})
+    {
+        remove_download(destination);
+        auto const begin = std::chrono::steady_clock::now();
+        auto const res   = download_file(server.url(), destination, {.max_nb_of_segments = nb_segments}, [](float) {}, []() { return false; });
+        auto const duration = std::chrono::duration<double>{std::chrono::steady_clock::now() - begin};
+        CHECK(res.has_value());
+        MESSAGE(fmt::format("{:>2} segment(s): {:.0f} MB/s", nb_segments, static_cast<double>(content.size()) / 1'000'000. / duration.count()));
+    }
+    remove_download(destination);
+}
+#endif
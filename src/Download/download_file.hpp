@@ -0,0 +1,25 @@
+#pragma once
+#include "tl/expected.hpp"
+
+struct DownloadOptions {
+    /// If the server supports Range requests, the file is split in up to this many segments that are downloaded in parallel, each over its own connection
+    size_t max_nb_of_segments{4};
+    /// If set, the file is downloaded sequentially, and this is called each time the first `nb_bytes` of the file have been written to disk and can be read by someone else.
+    /// This allows us to start processing the beginning of the file while the rest is still downloading. If the download has to restart from scratch, it is called with a smaller `nb_bytes` than before.
+    std::function<void(uint64_t nb_bytes)> on_bytes_available{};
+    /// If set, the download fails (and is deleted) if the SHA-256 of the file we received doesn't match
+    std::optional<std::string> expected_sha256{};
+    /// If set, it is called after each chunk we receive, and can block to slow down the download (it may be called from several threads at once)
+    std::function<void(uint64_t nb_bytes)> throttle{};
+};
+
+/// Downloads the file at `url` into `destination`. Chunks are written to disk as soon as they arrive, so we never hold the whole file in memory.
+/// If `wants_to_cancel()` returns true, the download stops and no error is returned.
+/// If the download gets interrupted (cancelled, connection lost, crash, etc.) what has already been downloaded is kept, and calling this function again will resume from there.
+/// Returns the SHA-256 of the file (or an empty string if cancelled). It is computed while the file is downloading, so there is no second pass over the file once it is complete.
+auto download_file(std::string const& url, std::filesystem::path const& destination, DownloadOptions const& options, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<std::string, std::string>;
+
+/// Removes the downloaded file, unless it is an incomplete download that we will be able to resume later
+void remove_download_unless_it_can_be_resumed(std::filesystem::path const& destination);
+void remove_download(std::filesystem::path const& destination);
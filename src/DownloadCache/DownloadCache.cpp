@@ -0,0 +1,283 @@
+#include "DownloadCache.hpp"
+#include <fstream>
+#include <mutex>
+#include "Cool/File/File.h"
+#include "Cool/Serialization/Json.hpp"
+#include "Hash/Sha256.hpp"
+#include "Path.hpp"
+#include "nlohmann/json.hpp"
+
+namespace DownloadCache {
+
+struct Entry {
+    std::string           url{};
+    std::filesystem::path file_name{};
+    std::string           sha256{};
+    uint64_t              size{};
+    uint64_t              last_use{}; // Incremented each time an entry is used, so that we know which one is the least recently used
+};
+
+static auto index_path(std::filesystem::path const& cache_folder) -> std::filesystem::path
+{
+    return cache_folder / "index.json";
+}
+
+static auto load_index(std::filesystem::path const& cache_folder) -> std::vector<Entry>
+{
+    auto file = std::ifstream{index_path(cache_folder)};
+    if (!file.is_open())
+        return {};
+
+    try
+    {
+        auto const json    = nlohmann::json::parse(file);
+        auto       entries = std::vector<Entry>{};
+        for (auto const& entry_json : json.at("Entries"))
+        {
+            auto entry = Entry{};
+            Cool::json_get(entry_json, "URL", entry.url);
+            entry.file_name = entry_json.at("File").get<std::string>();
+            Cool::json_get(entry_json, "SHA-256", entry.sha256);
+            Cool::json_get(entry_json, "Size", entry.size);
+            Cool::json_get(entry_json, "Last use", entry.last_use);
+            entries.push_back(std::move(entry));
+        }
+        return entries;
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Download cache", e.what());
+        return {};
+    }
+}
+
+static void save_index(std::filesystem::path const& cache_folder, std::vector<Entry> const& entries)
+{
+    auto entries_json = nlohmann::json::array();
+    for (auto const& entry : entries)
+    {
+        auto entry_json = nlohmann::json{};
+        Cool::json_set(entry_json, "URL", entry.url);
+        entry_json["File"] = entry.file_name.string();
+        Cool::json_set(entry_json, "SHA-256", entry.sha256);
+        Cool::json_set(entry_json, "Size", entry.size);
+        Cool::json_set(entry_json, "Last use", entry.last_use);
+        entries_json.push_back(std::move(entry_json));
+    }
+    auto json       = nlohmann::json{};
+    json["Entries"] = std::move(entries_json);
+    Cool::File::set_content(index_path(cache_folder), json.dump());
+}
+
+static auto next_use(std::vector<Entry> const& entries) -> uint64_t
+{
+    auto res = uint64_t{0};
+    for (auto const& entry : entries)
+        res = std::max(res, entry.last_use);
+    return res + 1;
+}
+
+/// The index is shared by all the install tasks, which can run at the same time
+static auto index_mutex() -> std::mutex&
+{
+    static auto instance = std::mutex{};
+    return instance;
+}
+
+/// "https://github.com/Coollab-Art/Coollab/releases/download/1.2.0/Coollab.AppImage" -> "1.2.0/Coollab.AppImage"
+static auto path_in_mirror(std::string const& url) -> std::optional<std::filesystem::path>
+{
+    auto const path          = std::string_view{url}.substr(0, url.find_first_of("?#"));
+    auto const last_slash    = path.rfind('/');
+    auto const release_slash = last_slash == std::string_view::npos || last_slash == 0 ? std::string_view::npos : path.rfind('/', last_slash - 1);
+    if (release_slash == std::string_view::npos || last_slash + 1 == path.size())
+        return std::nullopt;
+    auto const release_tag = path.substr(release_slash + 1, last_slash - release_slash - 1);
+    auto const asset_name  = path.substr(last_slash + 1);
+    if (release_tag.empty() || release_tag == ".." || asset_name == "..")
+        return std::nullopt;
+    return std::filesystem::path{release_tag} / asset_name;
+}
+
+static auto find_in_mirror(std::filesystem::path const& mirror_folder, std::string const& url, std::optional<std::string> const& expected_sha256) -> std::optional<LocalAsset>
+{
+    if (mirror_folder.empty())
+        return std::nullopt;
+    auto const relative_path = path_in_mirror(url);
+    if (!relative_path || !Cool::File::exists(mirror_folder / *relative_path))
+        return std::nullopt;
+
+    auto const path   = mirror_folder / *relative_path;
+    auto       sha256 = sha256_of_file(path); // The mirror is read-only, so we can't store its hashes anywhere
+    if (!sha256)
+        return std::nullopt;
+    if (expected_sha256 && *expected_sha256 != *sha256)
+    {
+        Cool::Log::internal_warning("Download cache", fmt::format("\"{}\" doesn't match its published checksum, ignoring it", path));
+        return std::nullopt;
+    }
+    return LocalAsset{path, std::move(*sha256)};
+}
+
+static auto find_in_cache(std::filesystem::path const& cache_folder, std::string const& url, std::optional<std::string> const& expected_sha256) -> std::optional<LocalAsset>
+{
+    auto const is_wanted_entry = [&](Entry const& entry) {
+        return entry.url == url && (!expected_sha256 || entry.sha256 == *expected_sha256);
+    };
+    auto file_name = std::filesystem::path{};
+    {
+        auto       lock    = std::unique_lock{index_mutex()};
+        auto const entries = load_index(cache_folder);
+        auto const it      = std::find_if(entries.begin(), entries.end(), is_wanted_entry);
+        if (it == entries.end())
+            return std::nullopt;
+        file_name = it->file_name;
+    }
+
+    // The file is a hardlink to the one of an installed version, so it might have been modified behind our back, even without changing its size
+    // Hashed without holding the lock, because it takes a while and the other installs might need the cache in the meantime
+    auto const path   = cache_folder / file_name;
+    auto const sha256 = sha256_of_file(path);
+
+    auto lock    = std::unique_lock{index_mutex()};
+    auto entries = load_index(cache_folder);
+    auto it      = std::find_if(entries.begin(), entries.end(), is_wanted_entry);
+    if (it == entries.end() || it->file_name != file_name)
+        return std::nullopt; // It has been evicted or replaced while we were hashing it
+    if (sha256 != it->sha256)
+    {
+        Cool::Log::internal_warning("Download cache", fmt::format("\"{}\" has been modified, removing it from the cache", path));
+        Cool::File::remove_file(path);
+        std::erase_if(entries, [&](Entry const& entry) { return entry.file_name == file_name; }); // All the urls that share this file
+        save_index(cache_folder, entries);
+        return std::nullopt;
+    }
+
+    it->last_use = next_use(entries);
+    save_index(cache_folder, entries);
+    return LocalAsset{path, it->sha256};
+}
+
+/// Removes the least recently used entries until the cache fits in `max_size`
+static void evict(std::filesystem::path const& cache_folder, std::vector<Entry>& entries, uint64_t max_size)
+{
+    std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) {
+        return a.last_use > b.last_use;
+    });
+    auto total_size = uint64_t{0};
+    for (auto const& entry : entries)
+        total_size += entry.size;
+    while (total_size > max_size && !entries.empty())
+    {
+        auto const evicted = entries.back();
+        entries.pop_back();
+        total_size -= evicted.size;
+        if (std::none_of(entries.begin(), entries.end(), [&](Entry const& entry) { return entry.file_name == evicted.file_name; })) // Several urls can share the same file
+            Cool::File::remove_file(cache_folder / evicted.file_name);
+    }
+}
+
+static void add_to_cache(std::filesystem::path const& cache_folder, uint64_t max_size, std::string const& url, std::filesystem::path const& file, std::string const& sha256)
+{
+    auto       error_code = std::error_code{};
+    auto const size       = std::filesystem::file_size(file, error_code);
+    if (error_code || size > max_size)
+        return;
+
+    auto lock    = std::unique_lock{index_mutex()};
+    auto entries = load_index(cache_folder);
+    std::erase_if(entries, [&](Entry const& entry) { return entry.url == url; }); // The asset might have been replaced on the server
+
+    // Name the file after its content, so that two urls that serve the same file share it
+    auto const file_name = std::filesystem::path{sha256 + file.extension().string()};
+    auto const path      = cache_folder / file_name;
+    if (!Cool::File::exists(path))
+    {
+        if (!Cool::File::create_folders_for_file_if_they_dont_exist(path))
+            return;
+        std::filesystem::create_hard_link(file, path, error_code); // The file we downloaded is about to be deleted (or is installed and never modified), so we don't need a copy
+        if (error_code)
+        {
+            error_code.clear();
+            std::filesystem::copy_file(file, path, error_code);
+            if (error_code)
+                return;
+        }
+    }
+
+    entries.push_back({url, file_name, sha256, size, next_use(entries)});
+    evict(cache_folder, entries, max_size); // Never evicts the entry we just added, because it is the most recently used one and it fits in the cache
+    save_index(cache_folder, entries);
+}
+
+auto find(std::string const& url, std::optional<std::string> const& expected_sha256, std::filesystem::path const& mirror_folder) -> std::optional<LocalAsset>
+{
+    if (auto asset = find_in_mirror(mirror_folder, url, expected_sha256))
+        return asset;
+    return find_in_cache(Path::download_cache_folder(), url, expected_sha256);
+}
+
+void add(std::string const& url, std::filesystem::path const& file, std::string const& sha256, uint64_t max_size)
+{
+    add_to_cache(Path::download_cache_folder(), max_size, url, file, sha256);
+}
+
+} // namespace DownloadCache
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+
+TEST_CASE("Path of a release asset in the mirror")
+{
+    CHECK(DownloadCache::path_in_mirror("https://github.com/Coollab-Art/Coollab/releases/download/1.2.0/Coollab.AppImage") == std::filesystem::path{"1.2.0"} / "Coollab.AppImage");
+    CHECK(DownloadCache::path_in_mirror("https://example.com/1.2.0/Coollab-Windows.zip?token=abc") == std::filesystem::path{"1.2.0"} / "Coollab-Windows.zip");
+    CHECK(!DownloadCache::path_in_mirror("https://example.com/releases/").has_value());
+    CHECK(!DownloadCache::path_in_mirror("https://example.com/../Coollab.AppImage").has_value());
+}
+
+TEST_CASE("Download cache")
+{
+    auto const folder = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "download_cache";
+    auto const cache  = folder / "Cache";
+    auto const mirror = folder / "Mirror";
+    Cool::File::remove_folder(folder);
+    Cool::File::set_content(folder / "1.zip", std::string(400, '1'));
+    Cool::File::set_content(folder / "2.zip", std::string(400, '2'));
+    Cool::File::set_content(folder / "3.zip", std::string(400, '3'));
+    auto const sha256 = [&](std::string const& name) {
+        return *sha256_of_file(folder / name);
+    };
+
+    DownloadCache::add_to_cache(cache, 1000, "https://example.com/1.0.0/1.zip", folder / "1.zip", sha256("1.zip"));
+    DownloadCache::add_to_cache(cache, 1000, "https://example.com/2.0.0/2.zip", folder / "2.zip", sha256("2.zip"));
+    auto const asset_1 = DownloadCache::find_in_cache(cache, "https://example.com/1.0.0/1.zip", std::nullopt); // Now 1 is more recently used than 2
+    REQUIRE(asset_1.has_value());
+    CHECK(asset_1->sha256 == sha256("1.zip"));
+    CHECK(sha256_of_file(asset_1->path) == sha256("1.zip"));
+    CHECK(!DownloadCache::find_in_cache(cache, "https://example.com/1.0.0/1.zip", "not the published checksum").has_value());
+
+    // Doesn't fit, so the least recently used one is evicted
+    DownloadCache::add_to_cache(cache, 1000, "https://example.com/3.0.0/3.zip", folder / "3.zip", sha256("3.zip"));
+    CHECK(DownloadCache::find_in_cache(cache, "https://example.com/1.0.0/1.zip", std::nullopt).has_value());
+    CHECK(!DownloadCache::find_in_cache(cache, "https://example.com/2.0.0/2.zip", std::nullopt).has_value());
+    CHECK(DownloadCache::find_in_cache(cache, "https://example.com/3.0.0/3.zip", sha256("3.zip")).has_value());
+
+    // The file we added has been modified in place (e.g. it was installed, and the cache shares its bytes), without changing its size
+    auto const sha256_before_modification = sha256("3.zip");
+    {
+        auto file = std::ofstream{folder / "3.zip", std::ios::binary | std::ios::in | std::ios::out};
+        file << "modified";
+    }
+    if (sha256_of_file(cache / (sha256_before_modification + ".zip")) != sha256_before_modification) // Otherwise the filesystem doesn't support hardlinks and we had to make a copy
+        CHECK(!DownloadCache::find_in_cache(cache, "https://example.com/3.0.0/3.zip", std::nullopt).has_value());
+    CHECK(DownloadCache::find_in_cache(cache, "https://example.com/1.0.0/1.zip", std::nullopt).has_value());
+
+    // Mirror
+    Cool::File::set_content(mirror / "2.0.0/2.zip", std::string(400, '2'));
+    CHECK(DownloadCache::find_in_mirror(mirror, "https://example.com/2.0.0/2.zip", sha256("2.zip")).has_value());
+    CHECK(!DownloadCache::find_in_mirror(mirror, "https://example.com/2.0.0/2.zip", sha256("3.zip")).has_value());
+    CHECK(!DownloadCache::find_in_mirror(mirror, "https://example.com/1.0.0/1.zip", std::nullopt).has_value());
+
+    Cool::File::remove_folder(folder);
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+/// Keeps the release assets we downloaded (AppImage / zip), so that reinstalling a version doesn't need to download it again.
+/// Users can also provide a read-only mirror folder (e.g. a network share) that is checked before the cache. It must have the same layout as the Github download urls: <mirror>/<release tag>/<asset name>
+namespace DownloadCache {
+
+struct LocalAsset {
+    std::filesystem::path path;
+    std::string           sha256;
+};
+
+/// Looks for the asset in the mirror folder (if not empty), then in the cache. Returns nullopt if we need to download it.
+/// If we know the checksum that the asset must have, we only return a file that matches it.
+/// The file is always hashed before being returned, because the cache shares its bytes with the installed versions, which could have been modified.
+auto find(std::string const& url, std::optional<std::string> const& expected_sha256, std::filesystem::path const& mirror_folder) -> std::optional<LocalAsset>;
+/// Keeps a copy of an asset that we just downloaded. The least recently used assets are evicted so that the cache doesn't exceed `max_size` bytes
+void add(std::string const& url, std::filesystem::path const& file, std::string const& sha256, uint64_t max_size);
+
+} // namespace DownloadCache
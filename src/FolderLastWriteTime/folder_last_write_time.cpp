@@ -0,0 +1,10 @@
+#include "folder_last_write_time.hpp"
+
+auto folder_last_write_time(std::filesystem::path const& folder) -> std::optional<int64_t>
+{
+    auto       error_code      = std::error_code{};
+    auto const last_write_time = std::filesystem::last_write_time(folder, error_code);
+    if (error_code)
+        return std::nullopt;
+    return static_cast<int64_t>(last_write_time.time_since_epoch().count());
+}
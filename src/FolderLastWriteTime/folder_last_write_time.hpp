@@ -0,0 +1,6 @@
+#pragma once
+
+/// Changes each time a file or folder is added to or removed from the folder (but not when the content of one of its subfolders changes).
+/// We save it next to the lists we keep of the content of a folder (installed versions, projects, etc.), to know when someone else changed that folder without us knowing.
+/// Returns nullopt if the folder doesn't exist.
+auto folder_last_write_time(std::filesystem::path const& folder) -> std::optional<int64_t>;
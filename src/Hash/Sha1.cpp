@@ -0,0 +1,33 @@
+#include "Sha1.hpp"
+#include <openssl/evp.h>
+#include <fstream>
+
+auto sha1_of_file(std::filesystem::path const& path) -> std::optional<std::string>
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    if (!file.is_open())
+        return std::nullopt;
+
+    EVP_MD_CTX* context = EVP_MD_CTX_new();
+    auto const  scope_guard = sg::make_scope_guard([&] { EVP_MD_CTX_free(context); });
+    EVP_DigestInit_ex(context, EVP_sha1(), nullptr);
+
+    auto buffer = std::vector<char>(1'000'000);
+    while (file)
+    {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        EVP_DigestUpdate(context, buffer.data(), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad())
+        return std::nullopt;
+
+    auto     digest = std::array<unsigned char, EVP_MAX_MD_SIZE>{};
+    unsigned size{0};
+    EVP_DigestFinal_ex(context, digest.data(), &size);
+
+    auto res = std::string{};
+    res.reserve(2 * size);
+    for (unsigned i = 0; i < size; ++i)
+        res += fmt::format("{:02x}", digest[i]);
+    return res;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+/// Returns the SHA-1 of the file as a lowercase hexadecimal string, or nullopt if the file can't be read
+/// Only use it to check files against checksums published in the SHA-1 format (e.g. by zsync), prefer SHA-256 otherwise
+auto sha1_of_file(std::filesystem::path const& path) -> std::optional<std::string>;
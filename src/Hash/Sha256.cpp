@@ -0,0 +1,61 @@
+#include "Sha256.hpp"
+#include <openssl/evp.h>
+#include <fstream>
+
+Sha256::Sha256()
+    : _context{EVP_MD_CTX_new()}
+{
+    EVP_DigestInit_ex(_context, EVP_sha256(), nullptr);
+}
+
+Sha256::~Sha256()
+{
+    EVP_MD_CTX_free(_context);
+}
+
+void Sha256::update(char const* data, size_t size)
+{
+    EVP_DigestUpdate(_context, data, size);
+}
+
+auto Sha256::finalize() -> std::string
+{
+    auto     digest = std::array<unsigned char, EVP_MAX_MD_SIZE>{};
+    unsigned size{0};
+    EVP_DigestFinal_ex(_context, digest.data(), &size);
+
+    auto res = std::string{};
+    res.reserve(2 * size);
+    for (unsigned i = 0; i < size; ++i)
+        res += fmt::format("{:02x}", digest[i]);
+    return res;
+}
+
+auto sha256_of_file(std::filesystem::path const& path) -> std::optional<std::string>
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    if (!file.is_open())
+        return std::nullopt;
+
+    auto sha256 = Sha256{};
+    auto buffer = std::vector<char>(1'000'000);
+    while (file)
+    {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        sha256.update(buffer.data(), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad())
+        return std::nullopt;
+    return sha256.finalize();
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+TEST_CASE("SHA-256")
+{
+    auto sha256 = Sha256{};
+    sha256.update("ab", 2);
+    sha256.update("c", 1);
+    CHECK(sha256.finalize() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+#endif
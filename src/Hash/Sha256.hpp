@@ -0,0 +1,24 @@
+#pragma once
+
+struct evp_md_ctx_st; // From OpenSSL, so that we don't have to include it in this header
+
+/// Computes a SHA-256 incrementally, so that data can be hashed chunk by chunk as it arrives, without a second pass over it
+class Sha256 {
+public:
+    Sha256();
+    ~Sha256();
+    Sha256(Sha256 const&)                = delete;
+    Sha256& operator=(Sha256 const&)     = delete;
+    Sha256(Sha256&&) noexcept            = delete;
+    Sha256& operator=(Sha256&&) noexcept = delete;
+
+    void update(char const* data, size_t size);
+    /// Returns the hash as a lowercase hexadecimal string. Must only be called once, after all the data has been passed to update()
+    auto finalize() -> std::string;
+
+private:
+    evp_md_ctx_st* _context;
+};
+
+/// Returns nullopt if the file can't be read
+auto sha256_of_file(std::filesystem::path const& path) -> std::optional<std::string>;
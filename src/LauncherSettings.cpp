@@ -15,9 +15,81 @@ void LauncherSettings::imgui()
 
     b |= Cool::ImGuiExtras::toggle("Automatically upgrade projects to the latest compatible version", &automatically_upgrade_projects_to_latest_compatible_version);
 
+    {
+        auto mirror_folder = _download_mirror_folder; // Edit a copy, so that the install tasks never read the string while ImGui is modifying it
+        if (ImGui::InputText("Downloads mirror folder", &mirror_folder))
+        {
+            auto lock               = std::unique_lock{_mutex};
+            _download_mirror_folder = std::move(mirror_folder);
+            b                       = true;
+        }
+    }
+    Cool::ImGuiExtras::help_marker("Folder (e.g. a network share) where we look for the versions before downloading them. It must be organized like the download links of Github: <mirror folder>/<version>/<file>");
+    {
+        auto cache_max_size_in_MB = _download_cache_max_size_in_MB;
+        if (ImGui::InputInt("Downloads cache size (MB)", &cache_max_size_in_MB))
+        {
+            auto lock                      = std::unique_lock{_mutex};
+            _download_cache_max_size_in_MB = std::max(cache_max_size_in_MB, 0);
+            b                              = true;
+        }
+    }
+    Cool::ImGuiExtras::help_marker("We keep the versions we downloaded, so that reinstalling them doesn't require to download them again");
+    {
+        auto max_nb_of_concurrent_installs = _max_nb_of_concurrent_installs;
+        if (ImGui::InputInt("Max number of versions installing at the same time", &max_nb_of_concurrent_installs))
+        {
+            auto lock                      = std::unique_lock{_mutex};
+            _max_nb_of_concurrent_installs = std::max(max_nb_of_concurrent_installs, 1);
+            b                              = true;
+        }
+    }
+    {
+        auto bandwidth_limit_in_kB_per_second = _background_installs_bandwidth_limit_in_kB_per_second;
+        if (ImGui::InputInt("Bandwidth of background installs (kB/s)", &bandwidth_limit_in_kB_per_second))
+        {
+            auto lock                                             = std::unique_lock{_mutex};
+            _background_installs_bandwidth_limit_in_kB_per_second = std::max(bandwidth_limit_in_kB_per_second, 0);
+            b                                                     = true;
+        }
+    }
+    Cool::ImGuiExtras::help_marker("Limits the bandwidth used by the versions that are installed automatically, so that they don't slow down your network. 0 means no limit. The versions you are waiting for (e.g. to open a project) are never limited");
+
     b |= Cool::ImGuiExtras::toggle("Show experimental versions", &show_experimental_versions);
     Cool::ImGuiExtras::help_marker("These versions are highly unstable and should only be used if you know what you are doing");
 
     if (b)
+    {
+        _generation++;
+        _needs_saving = true;
+    }
+    if (_needs_saving && !ImGui::IsAnyItemActive()) // Wait until the user has finished editing, instead of saving after each keystroke
+    {
         _serializer.save();
+        _needs_saving = false;
+    }
+}
+
+auto LauncherSettings::download_mirror_folder() const -> std::filesystem::path
+{
+    auto lock = std::unique_lock{_mutex};
+    return _download_mirror_folder;
+}
+
+auto LauncherSettings::download_cache_max_size_in_bytes() const -> uint64_t
+{
+    auto lock = std::unique_lock{_mutex};
+    return static_cast<uint64_t>(std::max(_download_cache_max_size_in_MB, 0)) * 1'000'000;
+}
+
+auto LauncherSettings::max_nb_of_concurrent_installs() const -> size_t
+{
+    auto lock = std::unique_lock{_mutex};
+    return static_cast<size_t>(std::max(_max_nb_of_concurrent_installs, 1));
+}
+
+auto LauncherSettings::background_installs_bandwidth_limit_in_bytes_per_second() const -> uint64_t
+{
+    auto lock = std::unique_lock{_mutex};
+    return static_cast<uint64_t>(std::max(_background_installs_bandwidth_limit_in_kB_per_second, 0)) * 1000;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include "Cool/Serialization/Json.hpp"
 #include "Cool/Serialization/JsonAutoSerializer.hpp"
 
@@ -9,19 +10,49 @@ struct LauncherSettings {
 
     void imgui();
     void save() { _serializer.save(); }
+    /// Changes each time the settings are modified through imgui(), so that you can cache things that depend on them
+    auto generation() const -> uint64_t { return _generation; }
+
+    /// Read-only folder (e.g. a network share) where we look for the release assets before downloading them
+    /// Can be called from any thread (e.g. by the install tasks), while the UI modifies it
+    auto download_mirror_folder() const -> std::filesystem::path;
+    /// Can be called from any thread (e.g. by the install tasks), while the UI modifies it
+    auto download_cache_max_size_in_bytes() const -> uint64_t;
+    /// Can be called from any thread (e.g. by the install tasks), while the UI modifies it
+    auto max_nb_of_concurrent_installs() const -> size_t;
+    /// 0 means no limit
+    /// Can be called from any thread (e.g. by the install tasks), while the UI modifies it
+    auto background_installs_bandwidth_limit_in_bytes_per_second() const -> uint64_t;
 
 private:
+    uint64_t _generation{0};
+    bool     _needs_saving{false};
+
+    mutable std::mutex _mutex{}; // Protects the settings that are read by other threads. The UI thread is the only one that modifies them, so it can read them without locking
+    std::string        _download_mirror_folder{};
+    int                _download_cache_max_size_in_MB{2000};
+    int                _max_nb_of_concurrent_installs{2};
+    int                _background_installs_bandwidth_limit_in_kB_per_second{0}; // 0 means no limit
+
     Cool::JsonAutoSerializer _serializer{
         "user_settings_launcher.json",
         false /*autosave_when_destroyed*/, // This is a static instance, so saving it in the destructor is dangerous because we don't know when it will happen exactly. Instead, we call save manually in App::on_shutdown()
         [&](nlohmann::json const& json) {
             Cool::json_get(json, "Automatically install latest version", automatically_install_latest_version);
             Cool::json_get(json, "Automatically upgrade projects to latest compatible version", automatically_upgrade_projects_to_latest_compatible_version);
+            Cool::json_get(json, "Download mirror folder", _download_mirror_folder);
+            Cool::json_get(json, "Download cache max size (MB)", _download_cache_max_size_in_MB);
+            Cool::json_get(json, "Max number of concurrent installs", _max_nb_of_concurrent_installs);
+            Cool::json_get(json, "Background installs bandwidth limit (kB/s)", _background_installs_bandwidth_limit_in_kB_per_second);
             /* Cool::json_get(json, "Show experimental versions", show_experimental_versions); */ // Don't serialize it because I don't want users to enable it once when I need to make them test something, then forget to disable it, and then see all the experimental versions and use them as if they were regular versions. Using an experimental version needs to be a very concious decision.
         },
         [&](nlohmann::json& json) {
             Cool::json_set(json, "Automatically install latest version", automatically_install_latest_version);
             Cool::json_set(json, "Automatically upgrade projects to latest compatible version", automatically_upgrade_projects_to_latest_compatible_version);
+            Cool::json_set(json, "Download mirror folder", _download_mirror_folder);
+            Cool::json_set(json, "Download cache max size (MB)", _download_cache_max_size_in_MB);
+            Cool::json_set(json, "Max number of concurrent installs", _max_nb_of_concurrent_installs);
+            Cool::json_set(json, "Background installs bandwidth limit (kB/s)", _background_installs_bandwidth_limit_in_kB_per_second);
             /* Cool::json_set(json, "Show experimental versions", show_experimental_versions); */ // Don't serialize it because I don't want users to enable it once when I need to make them test something, then forget to disable it, and then see all the experimental versions and use them as if they were regular versions. Using an experimental version needs to be a very concious decision.
         },
         false /*use_shared_user_data*/
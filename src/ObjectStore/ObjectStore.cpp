@@ -0,0 +1,394 @@
+#include "ObjectStore.hpp"
+#include <fstream>
+#include <set>
+#include "Cool/File/File.h"
+#include "Cool/Serialization/Json.hpp"
+#include "Hash/Sha256.hpp"
+#include "Path.hpp"
+#include "Version/installation_path.hpp"
+#include "nlohmann/json.hpp"
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
+namespace ObjectStore {
+
+static auto objects_folder(std::filesystem::path const& store_folder) -> std::filesystem::path
+{
+    return store_folder / "Files";
+}
+
+static auto object_path(std::filesystem::path const& store_folder, std::string const& object_id) -> std::filesystem::path
+{
+    return objects_folder(store_folder) / object_id.substr(0, 2) / object_id; // Split in several folders, because some filesystems get slow with too many files in a single folder
+}
+
+/// Remembers the size and last write time that an object had when we last checked its content, so that we don't have to hash it again as long as they don't change
+static auto stamp_path(std::filesystem::path const& store_folder, std::string const& object_id) -> std::filesystem::path
+{
+    return store_folder / "Stamps" / object_id.substr(0, 2) / object_id;
+}
+
+/// Lists all the objects used by a version
+static auto references_path(std::filesystem::path const& store_folder, std::string const& version_name) -> std::filesystem::path
+{
+    return store_folder / "References" / (version_name + ".json");
+}
+
+static auto object_id(std::filesystem::path const& file, std::string const& sha256) -> std::string
+{
+#if !defined(_WIN32)
+    // Hardlinks share their permissions, so an executable and a non-executable file with the same content must be different objects
+    if ((std::filesystem::status(file).permissions() & std::filesystem::perms::owner_exec) != std::filesystem::perms::none)
+        return sha256 + ".x";
+#else
+    std::ignore = file;
+#endif
+    return sha256;
+}
+
+/// Creates `destination` as a copy-on-write clone of `source`: they share their bytes on disk, but modifying one doesn't modify the other
+static auto reflink(std::filesystem::path const& source, std::filesystem::path const& destination) -> bool
+{
+#if defined(__linux__)
+    auto const source_file = open(source.c_str(), O_RDONLY); // NOLINT(*vararg)
+    if (source_file == -1)
+        return false;
+    auto const scope_guard = sg::make_scope_guard([&] { close(source_file); });
+
+    struct stat info{};
+    if (fstat(source_file, &info) != 0)
+        return false;
+    auto const destination_file = open(destination.c_str(), O_WRONLY | O_CREAT | O_EXCL, info.st_mode & 07777); // NOLINT(*vararg)
+    if (destination_file == -1)
+        return false;
+    auto const success = ioctl(destination_file, FICLONE, source_file) == 0; // NOLINT(*vararg)
+    close(destination_file);
+    if (!success)
+        unlink(destination.c_str()); // Most filesystems (e.g. ext4) don't support reflinks
+    return success;
+#elif defined(__APPLE__)
+    return clonefile(source.c_str(), destination.c_str(), 0) == 0;
+#else
+    std::ignore = source;
+    std::ignore = destination;
+    return false;
+#endif
+}
+
+/// Makes `destination` share its bytes on disk with `source`. Returns false if the filesystem supports neither reflinks nor hardlinks (e.g. FAT32)
+static auto share_file(std::filesystem::path const& source, std::filesystem::path const& destination) -> bool
+{
+    if (reflink(source, destination))
+        return true;
+    auto error_code = std::error_code{};
+    std::filesystem::create_hard_link(source, destination, error_code);
+    return !error_code;
+}
+
+struct ObjectStamp {
+    uint64_t size{};
+    int64_t  last_write_time{}; // Editing a file through any of its hardlinks changes it
+
+    friend auto operator==(ObjectStamp const&, ObjectStamp const&) -> bool = default;
+};
+
+static auto current_stamp(std::filesystem::path const& object) -> std::optional<ObjectStamp>
+{
+    auto       error_code = std::error_code{};
+    auto const size       = std::filesystem::file_size(object, error_code);
+    if (error_code)
+        return std::nullopt;
+    auto const last_write_time = std::filesystem::last_write_time(object, error_code);
+    if (error_code)
+        return std::nullopt;
+    return ObjectStamp{
+        .size            = size,
+        .last_write_time = static_cast<int64_t>(last_write_time.time_since_epoch().count()),
+    };
+}
+
+static auto load_stamp(std::filesystem::path const& path) -> std::optional<ObjectStamp>
+{
+    auto file = std::ifstream{path};
+    if (!file.is_open())
+        return std::nullopt;
+
+    try
+    {
+        auto const json = nlohmann::json::parse(file);
+        return ObjectStamp{
+            .size            = json.at(0).get<uint64_t>(),
+            .last_write_time = json.at(1).get<int64_t>(),
+        };
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Object store", e.what());
+        return std::nullopt;
+    }
+}
+
+static void save_stamp(std::filesystem::path const& path, ObjectStamp const& stamp)
+{
+    Cool::File::set_content(path, nlohmann::json{stamp.size, stamp.last_write_time}.dump());
+}
+
+/// Must be called once we know that the content of the object is valid
+static void stamp_object(std::filesystem::path const& store_folder, std::string const& object_id)
+{
+    auto const stamp = current_stamp(object_path(store_folder, object_id));
+    if (stamp)
+        save_stamp(stamp_path(store_folder, object_id), *stamp);
+}
+
+struct FileToStore {
+    std::filesystem::path path;
+    std::string           sha256;
+    std::string           object_id;
+};
+
+/// Checks the content of the object, because it could have been modified through one of the hardlinks to it
+/// Hashing the object is expensive, so we only do it if it has been modified since we last checked it
+static auto object_is_valid(std::filesystem::path const& store_folder, FileToStore const& file) -> bool
+{
+    auto const stamp = current_stamp(object_path(store_folder, file.object_id)); // Before hashing, so that if the object is modified while we hash it, it will be hashed again next time
+    if (!stamp)
+        return false;
+    auto error_code = std::error_code{};
+    if (std::filesystem::file_size(file.path, error_code) != stamp->size || error_code)
+        return false; // Much cheaper than hashing the object
+    if (load_stamp(stamp_path(store_folder, file.object_id)) == stamp)
+        return true;
+    if (sha256_of_file(object_path(store_folder, file.object_id)) != file.sha256)
+        return false;
+    save_stamp(stamp_path(store_folder, file.object_id), *stamp);
+    return true;
+}
+
+static void link_to_object(std::filesystem::path const& store_folder, FileToStore const& file_to_store)
+{
+    auto const& file       = file_to_store.path;
+    auto const  object     = object_path(store_folder, file_to_store.object_id);
+    auto        error_code = std::error_code{};
+    if (Cool::File::exists(object))
+    {
+        if (std::filesystem::equivalent(file, object, error_code))
+            return; // Already linked
+        if (object_is_valid(store_folder, file_to_store))
+        {
+            // Replace our copy with a link to the object. Go through a temporary file so that we never end up without the file if something goes wrong
+            auto const tmp_path = std::filesystem::path{file.string() + ".dedup"};
+            Cool::File::remove_file(tmp_path);
+            if (!share_file(object, tmp_path))
+                return;
+            std::filesystem::rename(tmp_path, file, error_code);
+            if (error_code)
+                Cool::File::remove_file(tmp_path);
+            return;
+        }
+        // The object has been corrupted (e.g. someone edited one of the hardlinks to it), replace it with our file
+        Cool::File::remove_file(object);
+    }
+
+    if (!Cool::File::create_folders_for_file_if_they_dont_exist(object))
+        return;
+    if (share_file(file, object)) // If another version is adding the same object at the same time, this will fail but the object will be there for the next versions anyways
+        stamp_object(store_folder, file_to_store.object_id);
+}
+
+static auto load_references(std::filesystem::path const& path) -> std::vector<std::string>
+{
+    auto file = std::ifstream{path};
+    if (!file.is_open())
+        return {};
+
+    try
+    {
+        auto const json = nlohmann::json::parse(file);
+        auto       res  = std::vector<std::string>{};
+        Cool::json_get(json, "Objects", res);
+        return res;
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Object store", e.what());
+        return {};
+    }
+}
+
+static void save_references(std::filesystem::path const& path, std::vector<std::string> const& object_ids)
+{
+    auto json = nlohmann::json{};
+    Cool::json_set(json, "Objects", object_ids);
+    Cool::File::set_content(path, json.dump());
+}
+
+static void deduplicate_folder(std::filesystem::path const& store_folder, std::string const& version_name, std::filesystem::path const& folder, VersionManifest& manifest, std::function<bool()> const& wants_to_cancel)
+{
+    try
+    {
+        auto files = std::vector<FileToStore>{};
+        for (auto const& entry : std::filesystem::recursive_directory_iterator{folder, std::filesystem::directory_options::skip_permission_denied})
+        {
+            if (wants_to_cancel())
+                return;
+            if (!entry.is_regular_file() || entry.is_symlink())
+                continue;
+            auto sha256 = manifest.known_sha256(folder, entry.path()); // e.g. the AppImage, which was hashed while it was downloading
+            if (!sha256)
+                sha256 = sha256_of_file(entry.path());
+            if (sha256)
+                files.push_back({entry.path(), *sha256, object_id(entry.path(), *sha256)});
+        }
+
+        {
+            auto object_ids = std::vector<std::string>{};
+            for (auto const& file : files)
+                object_ids.push_back(file.object_id);
+            std::sort(object_ids.begin(), object_ids.end());
+            object_ids.erase(std::unique(object_ids.begin(), object_ids.end()), object_ids.end());
+            // Save the references before adding anything to the store, so that a garbage collection happening at the same time (because another version is being uninstalled) doesn't delete the objects we are adding
+            save_references(references_path(store_folder, version_name), object_ids);
+        }
+
+        for (auto& file : files)
+        {
+            if (wants_to_cancel())
+                return;
+            link_to_object(store_folder, file);
+            manifest.set_sha256(folder, file.path, std::move(file.sha256)); // After linking, because it changes the last write time of the file
+        }
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Object store", e.what());
+    }
+}
+
+/// Deletes all the objects that are not referenced by any version
+/// NB: we don't store a counter for each object, the counts are recomputed from the lists of references of each version, which can never get out of sync with the versions that are actually installed
+static void collect_garbage(std::filesystem::path const& store_folder)
+{
+    try
+    {
+        auto referenced = std::set<std::string>{};
+        if (Cool::File::exists(store_folder / "References"))
+        {
+            for (auto const& entry : std::filesystem::directory_iterator{store_folder / "References"})
+            {
+                for (auto& id : load_references(entry.path()))
+                    referenced.insert(std::move(id));
+            }
+        }
+
+        for (auto const& folder : {objects_folder(store_folder), store_folder / "Stamps"})
+        {
+            if (!Cool::File::exists(folder))
+                continue;
+            auto unused_files = std::vector<std::filesystem::path>{};
+            for (auto const& entry : std::filesystem::recursive_directory_iterator{folder})
+            {
+                if (entry.is_regular_file() && !referenced.contains(entry.path().filename().string()))
+                    unused_files.push_back(entry.path());
+            }
+            for (auto const& file : unused_files)
+                Cool::File::remove_file(file);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Object store", e.what());
+    }
+}
+
+static void release_folder(std::filesystem::path const& store_folder, std::string const& version_name)
+{
+    Cool::File::remove_file(references_path(store_folder, version_name));
+    collect_garbage(store_folder);
+}
+
+void deduplicate(VersionName const& version_name, VersionManifest& manifest, std::function<bool()> const& wants_to_cancel)
+{
+    deduplicate_folder(Path::object_store_folder(), version_name.as_string_raw(), installation_path(version_name), manifest, wants_to_cancel);
+}
+
+void release(VersionName const& version_name)
+{
+    release_folder(Path::object_store_folder(), version_name.as_string_raw());
+}
+
+} // namespace ObjectStore
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+
+static auto read_file(std::filesystem::path const& path) -> std::string
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+static auto nb_files_in(std::filesystem::path const& folder) -> size_t
+{
+    if (!Cool::File::exists(folder))
+        return 0;
+    auto const files = std::filesystem::recursive_directory_iterator{folder};
+    return static_cast<size_t>(std::count_if(std::filesystem::begin(files), std::filesystem::end(files), [](auto const& entry) { return entry.is_regular_file(); }));
+}
+
+TEST_CASE("Object store")
+{
+    auto const folder = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "object_store";
+    auto const store  = folder / ".Objects";
+    Cool::File::remove_folder(folder);
+    Cool::File::set_content(folder / "1.0.0/shared.txt", "Shared by both versions");
+    Cool::File::set_content(folder / "1.0.0/res/only_in_1.txt", "Only in 1.0.0");
+    Cool::File::set_content(folder / "1.0.1/shared.txt", "Shared by both versions");
+    Cool::File::set_content(folder / "1.0.1/res/only_in_2.txt", "Only in 1.0.1");
+
+    auto manifest_1 = VersionManifest{};
+    auto manifest_2 = VersionManifest{};
+    ObjectStore::deduplicate_folder(store, "1.0.0", folder / "1.0.0", manifest_1, []() { return false; });
+    ObjectStore::deduplicate_folder(store, "1.0.1", folder / "1.0.1", manifest_2, []() { return false; });
+    CHECK(nb_files_in(store / "Files") == 3);
+    CHECK(nb_files_in(store / "Stamps") == 3);
+    CHECK(manifest_1.files.size() == 2);
+    CHECK(manifest_2.known_sha256(folder / "1.0.1", folder / "1.0.1/shared.txt") == sha256_of_file(folder / "1.0.1/shared.txt"));
+    CHECK(read_file(folder / "1.0.1/shared.txt") == "Shared by both versions");
+    CHECK(read_file(folder / "1.0.1/res/only_in_2.txt") == "Only in 1.0.1");
+
+    Cool::File::remove_folder(folder / "1.0.0");
+    ObjectStore::release_folder(store, "1.0.0");
+    CHECK(nb_files_in(store / "Files") == 2);
+    CHECK(nb_files_in(store / "Stamps") == 2);
+    CHECK(read_file(folder / "1.0.1/shared.txt") == "Shared by both versions");
+
+    // Someone edited the file of 1.0.1, which also modified the object it is linked to
+    {
+        auto file = std::ofstream{folder / "1.0.1/shared.txt", std::ios::binary | std::ios::in | std::ios::out};
+        file << "Edited";
+    }
+    std::filesystem::last_write_time(folder / "1.0.1/shared.txt", std::filesystem::last_write_time(folder / "1.0.1/shared.txt") + std::chrono::seconds{1}); // The edit happened so soon after the install that the filesystem might not see a difference in the last write time
+    Cool::File::set_content(folder / "1.0.2/shared.txt", "Shared by both versions");
+    auto manifest_3 = VersionManifest{};
+    ObjectStore::deduplicate_folder(store, "1.0.2", folder / "1.0.2", manifest_3, []() { return false; });
+    CHECK(read_file(folder / "1.0.2/shared.txt") == "Shared by both versions");
+    CHECK(read_file(ObjectStore::object_path(store, manifest_3.files.at("shared.txt").sha256)) == "Shared by both versions"); // The object has been replaced
+
+    Cool::File::remove_folder(folder / "1.0.1");
+    ObjectStore::release_folder(store, "1.0.1");
+    Cool::File::remove_folder(folder / "1.0.2");
+    ObjectStore::release_folder(store, "1.0.2");
+    CHECK(nb_files_in(store / "Files") == 0);
+    CHECK(nb_files_in(store / "Stamps") == 0);
+
+    Cool::File::remove_folder(folder);
+}
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+#include "Version/VersionManifest.hpp"
+#include "Version/VersionName.hpp"
+
+/// Consecutive releases share most of their files, so instead of keeping a full copy of each file in each installed version, we store each file only once, identified by its hash.
+/// The files of the installed versions are then reflinks (copy-on-write clones, where the filesystem supports it) or hardlinks to the files in the store.
+/// Each version keeps the list of the objects it uses, and an object is deleted once no version uses it anymore.
+namespace ObjectStore {
+
+/// Moves the files of this freshly installed version into the store, replacing them with links to the files that are already in the store if other versions share them
+/// This is an optimization, so it never fails: in the worst case the version keeps its own copy of its files
+/// The hashes already known by the manifest are reused, and the ones we compute are added to it.
+void deduplicate(VersionName const&, VersionManifest&, std::function<bool()> const& wants_to_cancel);
+/// Must be called once the version has been uninstalled. Deletes all the objects that are not used by any other version anymore
+void release(VersionName const&);
+
+} // namespace ObjectStore
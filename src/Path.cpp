@@ -8,11 +8,41 @@ auto installed_versions_folder() -> std::filesystem::path
     return Cool::Path::user_data() / "Installed Versions";
 }
 
+auto downloads_folder() -> std::filesystem::path
+{
+    return installed_versions_folder() / ".Downloads"; // Starts with a dot so that it can't be mistaken for an installed version
+}
+
+auto object_store_folder() -> std::filesystem::path
+{
+    return installed_versions_folder() / ".Objects"; // Starts with a dot so that it can't be mistaken for an installed version
+}
+
+auto download_cache_folder() -> std::filesystem::path
+{
+    return Cool::Path::user_data() / "Download Cache";
+}
+
+auto version_manifests_folder() -> std::filesystem::path
+{
+    return installed_versions_folder() / ".Manifests"; // Starts with a dot so that it can't be mistaken for an installed version
+}
+
+auto installed_versions_list_file() -> std::filesystem::path
+{
+    return version_manifests_folder() / "Installed versions.json"; // Not directly in installed_versions_folder(), because modifying it would change the last write time of that folder, which we use to know if the list is outdated
+}
+
 auto projects_info_folder() -> std::filesystem::path
 {
     return Cool::Path::user_data() / "Projects Info";
 }
 
+auto projects_catalog_file() -> std::filesystem::path
+{
+    return Cool::Path::user_data() / "Projects catalog.jsonl"; // Not in projects_info_folder(), because modifying it would change the last write time of that folder, which we use to know if the catalog is outdated
+}
+
 auto default_projects_folder() -> std::filesystem::path
 {
     return Cool::Path::user_data() / "Projects";
@@ -23,4 +53,14 @@ auto versions_compatibility_file() -> std::filesystem::path
     return Cool::Path::user_data() / "versions_compatibility.txt";
 }
 
+auto releases_list_file() -> std::filesystem::path
+{
+    return Cool::Path::user_data() / "releases.json";
+}
+
+auto release_catalog_file() -> std::filesystem::path
+{
+    return Cool::Path::user_data() / "release_catalog.json";
+}
+
 } // namespace Path
\ No newline at end of file
@@ -4,10 +4,26 @@ namespace Path {
 
 /// Folder where all the Coollab releases will be installed
 auto installed_versions_folder() -> std::filesystem::path;
+/// Folder where the releases are downloaded to, before being installed
+auto downloads_folder() -> std::filesystem::path;
+/// Folder where the files shared by several installed versions are stored only once
+auto object_store_folder() -> std::filesystem::path;
+/// Folder where we keep the release assets we downloaded, so that reinstalling a version doesn't require to download it again
+auto download_cache_folder() -> std::filesystem::path;
+/// Folder where we store what we know about each installed version (e.g. the hashes of its files)
+auto version_manifests_folder() -> std::filesystem::path;
+/// The list of installed versions, so that we don't have to scan installed_versions_folder() at startup
+auto installed_versions_list_file() -> std::filesystem::path;
 /// Folder where all the projects info are stored, for all the projects that are tracked by the launcher
 auto projects_info_folder() -> std::filesystem::path;
+/// What we know about the projects in projects_info_folder(), so that we don't have to read all of them at startup
+auto projects_catalog_file() -> std::filesystem::path;
 /// Folder where all the projects are stored by default
 auto default_projects_folder() -> std::filesystem::path;
 auto versions_compatibility_file() -> std::filesystem::path;
+/// The last list of releases we received from Github
+auto releases_list_file() -> std::filesystem::path;
+/// What we parsed from that list, so that we don't need to wait for the network to know which versions are available
+auto release_catalog_file() -> std::filesystem::path;
 
 } // namespace Path
\ No newline at end of file
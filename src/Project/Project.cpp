@@ -6,10 +6,18 @@
 #include "Cool/Utils/getline.hpp"
 #include "Cool/Utils/overloaded.hpp"
 #include "LauncherSettings.hpp"
+#include "Version/VersionManager.hpp"
 #include "Version/VersionName.hpp"
 #include "VersionCompatibility/VersionCompatibility.hpp"
 #include "range/v3/view.hpp"
 
+Project::Project(std::filesystem::path file_path, std::filesystem::file_time_type time_of_last_change, std::optional<VersionName> version)
+    : Project{std::move(file_path)}
+{
+    _time_of_last_change.get_value([&]() { return time_of_last_change; });
+    _version_name.get_value([&]() { return std::move(version); });
+}
+
 auto Project::name() const -> std::string
 {
     return Cool::File::file_name_without_extension(_file_path).string();
@@ -19,7 +27,7 @@ auto Project::file_not_found() const -> bool
 {
     auto const not_found = !Cool::File::exists(file_path());
     if (not_found)
-        _version_name.invalidate_cache();
+        invalidate_version_cache();
     return not_found;
 }
 
@@ -40,6 +48,27 @@ auto Project::version_to_upgrade_to() const -> VersionToUpgradeTo
     if (_version_to_upgrade_to_selected_by_user.has_value())
         return *_version_to_upgrade_to_selected_by_user;
 
+    // Read the generations before computing, so that if something changes in the meantime we will recompute it next time
+    auto const versions_generation      = version_manager().generation();
+    auto const compatibility_generation = version_compatibility().generation();
+    auto const settings_generation      = launcher_settings().generation();
+    if (!_automatic_upgrade.has_value()
+        || _automatic_upgrade->versions_generation != versions_generation
+        || _automatic_upgrade->compatibility_generation != compatibility_generation
+        || _automatic_upgrade->settings_generation != settings_generation)
+    {
+        _automatic_upgrade = AutomaticUpgrade{
+            .version                  = version_to_upgrade_to_automatically(),
+            .versions_generation      = versions_generation,
+            .compatibility_generation = compatibility_generation,
+            .settings_generation      = settings_generation,
+        };
+    }
+    return _automatic_upgrade->version;
+}
+
+auto Project::version_to_upgrade_to_automatically() const -> VersionToUpgradeTo
+{
     if (!launcher_settings().automatically_upgrade_projects_to_latest_compatible_version)
         return DontUpgrade{};
 
@@ -112,10 +141,16 @@ void Project::set_file_path(std::filesystem::path file_path)
 {
     _file_path = std::move(file_path);
     _next_name = Cool::File::file_name_without_extension(_file_path).string();
-    _version_name.invalidate_cache();
+    invalidate_version_cache();
     _time_of_last_change.invalidate_cache();
 }
 
+void Project::invalidate_version_cache() const
+{
+    _version_name.invalidate_cache();
+    _automatic_upgrade.reset(); // It depends on the version
+}
+
 void Project::imgui_version_to_upgrade_to()
 {
     const char* label = "Upgrade Coollab version";
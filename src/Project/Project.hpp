@@ -13,6 +13,8 @@ public:
         : _file_path{std::move(file_path)}
         , _next_name{Cool::File::file_name_without_extension(_file_path).string()}
     {}
+    /// When we already know them (e.g. from the ProjectCatalog), so that we don't have to read them from the disk
+    Project(std::filesystem::path file_path, std::filesystem::file_time_type time_of_last_change, std::optional<VersionName> version);
 
     auto file_path() const -> std::filesystem::path { return Cool::File::weakly_canonical(_file_path); }
     auto file_not_found() const -> bool;
@@ -31,9 +33,22 @@ public:
 private:
     friend class ProjectManager;
 
+    auto version_to_upgrade_to_automatically() const -> VersionToUpgradeTo;
+    void invalidate_version_cache() const;
+
+    /// Cached because it is needed several times per frame, for each project.
+    /// It is valid for as long as the generations of the things it depends on don't change.
+    struct AutomaticUpgrade {
+        VersionToUpgradeTo version{DontUpgrade{}};
+        uint64_t           versions_generation{};
+        uint64_t           compatibility_generation{};
+        uint64_t           settings_generation{};
+    };
+
     std::filesystem::path                                 _file_path{};
     std::string                                           _next_name{};
     mutable Cool::Cached<std::optional<VersionName>>      _version_name{};
     std::optional<VersionToUpgradeTo>                     _version_to_upgrade_to_selected_by_user{std::nullopt};
     mutable Cool::Cached<std::filesystem::file_time_type> _time_of_last_change{};
+    mutable std::optional<AutomaticUpgrade>               _automatic_upgrade{};
 };
\ No newline at end of file
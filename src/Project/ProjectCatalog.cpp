@@ -0,0 +1,216 @@
+#include "ProjectCatalog.hpp"
+#include <fstream>
+#include "Cool/File/File.h"
+#include "Cool/Serialization/Json.hpp"
+#include "Cool/Utils/getline.hpp"
+#include "FolderLastWriteTime/folder_last_write_time.hpp"
+#include "Path.hpp"
+#include "nlohmann/json.hpp"
+
+static auto to_json(std::string const& folder_name, ProjectCatalogEntry const& entry) -> nlohmann::json
+{
+    auto json = nlohmann::json{};
+    Cool::json_set(json, "Folder", folder_name);
+    json["Path"] = entry.file_path.string();
+    if (entry.time_of_last_change.has_value())
+        Cool::json_set(json, "Time of last change", static_cast<int64_t>(entry.time_of_last_change->time_since_epoch().count()));
+    if (entry.version.has_value())
+        Cool::json_set(json, "Version", entry.version->as_string_raw());
+    return json;
+}
+
+static auto entry_from_json(nlohmann::json const& json) -> ProjectCatalogEntry
+{
+    auto entry      = ProjectCatalogEntry{};
+    entry.file_path = json.at("Path").get<std::string>();
+    if (json.contains("Time of last change"))
+        entry.time_of_last_change = std::filesystem::file_time_type{std::filesystem::file_time_type::duration{json.at("Time of last change").get<int64_t>()}};
+    if (json.contains("Version"))
+        entry.version = VersionName::from(json.at("Version").get<std::string>());
+    return entry;
+}
+
+static void save_project_catalog(std::filesystem::path const& catalog_path, std::filesystem::path const& info_folder, std::map<std::string, ProjectCatalogEntry> const& entries)
+{
+    if (!Cool::File::create_folders_for_file_if_they_dont_exist(catalog_path))
+        return;
+
+    // Write to another file first, and then replace the catalog with it, so that we never leave a half-written catalog behind us
+    auto const tmp_path = catalog_path.string() + ".tmp";
+    {
+        auto file = std::ofstream{tmp_path, std::ios::trunc};
+        if (!file.is_open())
+            return;
+        auto header = nlohmann::json{};
+        Cool::json_set(header, "Folder last write time", folder_last_write_time(info_folder).value_or(0));
+        file << header.dump() << '\n';
+        for (auto const& [folder_name, entry] : entries)
+            file << to_json(folder_name, entry).dump() << '\n';
+        if (!file.flush())
+            return;
+    }
+    auto error_code = std::error_code{};
+    std::filesystem::rename(tmp_path, catalog_path, error_code);
+    if (error_code)
+        Cool::Log::internal_warning("Save project catalog", error_code.message());
+}
+
+static void append_to_project_catalog(std::filesystem::path const& catalog_path, std::filesystem::path const& info_folder, std::optional<int64_t> folder_write_time_before_the_change, nlohmann::json record)
+{
+    Cool::json_set(record, "Folder last write time before the change", folder_write_time_before_the_change.value_or(0)); // If it doesn't match the time saved by the previous record, someone else changed the folder in between (e.g. Coollab created a project), and we need to look at the whole folder
+    Cool::json_set(record, "Folder last write time", folder_last_write_time(info_folder).value_or(0));                      // So that we know that this change of the folder is not one that happened without us knowing
+    auto file = std::ofstream{catalog_path, std::ios::app};
+    file << record.dump() << '\n'; // A single write, so that if we crash in the middle of it, only this line is lost
+}
+
+static auto load_project_catalog(std::filesystem::path const& catalog_path, std::filesystem::path const& info_folder) -> std::optional<ProjectCatalog>
+{
+    auto file = std::ifstream{catalog_path};
+    if (!file.is_open())
+        return std::nullopt;
+
+    auto catalog           = ProjectCatalog{};
+    auto folder_write_time = std::optional<int64_t>{};
+    auto nb_records        = size_t{0};
+    auto line              = std::string{};
+    while (Cool::getline(file, line))
+    {
+        if (line.empty())
+            continue;
+        try
+        {
+            auto const record = nlohmann::json::parse(line);
+            if (record.contains("Removed"))
+                catalog.entries.erase(record.at("Removed").get<std::string>());
+            if (record.contains("Folder"))
+                catalog.entries[record.at("Folder").get<std::string>()] = entry_from_json(record);
+            if (record.contains("Folder last write time before the change") && record.at("Folder last write time before the change").get<int64_t>() != folder_write_time)
+                catalog.might_be_outdated = true;
+            if (record.contains("Folder last write time"))
+                folder_write_time = record.at("Folder last write time").get<int64_t>();
+            nb_records++;
+        }
+        catch (std::exception const& e)
+        {
+            // We crashed in the middle of writing this line, and we might have missed some changes
+            Cool::Log::internal_warning("Load project catalog", e.what());
+            catalog.might_be_outdated = true;
+            break;
+        }
+    }
+    if (nb_records == 0)
+        return std::nullopt;
+
+    catalog.might_be_outdated |= folder_last_write_time(info_folder) != folder_write_time;
+    if (!catalog.might_be_outdated && nb_records > 2 * catalog.entries.size() + 64) // Most of the log is made of changes that have been overwritten since
+        save_project_catalog(catalog_path, info_folder, catalog.entries);
+    return catalog;
+}
+
+static void add_to_project_catalog(std::filesystem::path const& catalog_path, std::filesystem::path const& info_folder, std::optional<int64_t> folder_write_time_before_the_change, std::string const& folder_name, ProjectCatalogEntry const& entry, std::optional<std::string> const& replaced_folder_name)
+{
+    auto record = to_json(folder_name, entry);
+    if (replaced_folder_name.has_value() && *replaced_folder_name != folder_name)
+        Cool::json_set(record, "Removed", *replaced_folder_name); // In the same record, so that we can't save one change without the other
+    append_to_project_catalog(catalog_path, info_folder, folder_write_time_before_the_change, std::move(record));
+}
+
+static void remove_from_project_catalog(std::filesystem::path const& catalog_path, std::filesystem::path const& info_folder, std::optional<int64_t> folder_write_time_before_the_change, std::string const& folder_name)
+{
+    auto record = nlohmann::json{};
+    Cool::json_set(record, "Removed", folder_name);
+    append_to_project_catalog(catalog_path, info_folder, folder_write_time_before_the_change, std::move(record));
+}
+
+auto projects_info_folder_last_write_time() -> std::optional<int64_t>
+{
+    return folder_last_write_time(Path::projects_info_folder());
+}
+
+auto load_project_catalog() -> std::optional<ProjectCatalog>
+{
+    return load_project_catalog(Path::projects_catalog_file(), Path::projects_info_folder());
+}
+
+void save_project_catalog(std::map<std::string, ProjectCatalogEntry> const& entries)
+{
+    save_project_catalog(Path::projects_catalog_file(), Path::projects_info_folder(), entries);
+}
+
+void add_to_project_catalog(std::optional<int64_t> folder_write_time_before_the_change, std::string const& folder_name, ProjectCatalogEntry const& entry, std::optional<std::string> const& replaced_folder_name)
+{
+    add_to_project_catalog(Path::projects_catalog_file(), Path::projects_info_folder(), folder_write_time_before_the_change, folder_name, entry, replaced_folder_name);
+}
+
+void remove_from_project_catalog(std::optional<int64_t> folder_write_time_before_the_change, std::string const& folder_name)
+{
+    remove_from_project_catalog(Path::projects_catalog_file(), Path::projects_info_folder(), folder_write_time_before_the_change, folder_name);
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+
+TEST_CASE("Project catalog")
+{
+    auto const folder       = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "project_catalog";
+    auto const info_folder  = folder / "Projects Info";
+    auto const catalog_path = folder / "Projects catalog.jsonl";
+    Cool::File::remove_folder(folder);
+    Cool::File::set_content(info_folder / "a" / "path.txt", "a.coollab");
+    Cool::File::set_content(info_folder / "b" / "path.txt", "b.coollab");
+
+    CHECK(!load_project_catalog(catalog_path, info_folder).has_value());
+    auto const time = std::filesystem::file_time_type{std::filesystem::file_time_type::duration{123}};
+    save_project_catalog(catalog_path, info_folder, {
+                                                        {"a", {"a.coollab", time, VersionName::from("1.2.0")}},
+                                                        {"b", {"b.coollab", time, std::nullopt}},
+                                                    });
+    {
+        auto const catalog = load_project_catalog(catalog_path, info_folder);
+        REQUIRE(catalog.has_value());
+        CHECK(!catalog->might_be_outdated);
+        REQUIRE(catalog->entries.size() == 2);
+        CHECK(catalog->entries.at("a").file_path == "a.coollab");
+        CHECK(catalog->entries.at("a").time_of_last_change == time);
+        CHECK(catalog->entries.at("a").version == VersionName::from("1.2.0"));
+        CHECK(!catalog->entries.at("b").version.has_value());
+    }
+
+    // Rename b to c, and remove a
+    auto folder_write_time = folder_last_write_time(info_folder);
+    Cool::File::rename(info_folder / "b", info_folder / "c");
+    add_to_project_catalog(catalog_path, info_folder, folder_write_time, "c", {"c.coollab", std::nullopt, std::nullopt}, "b");
+    folder_write_time = folder_last_write_time(info_folder);
+    Cool::File::remove_folder(info_folder / "a");
+    remove_from_project_catalog(catalog_path, info_folder, folder_write_time, "a");
+    {
+        auto const catalog = load_project_catalog(catalog_path, info_folder);
+        REQUIRE(catalog.has_value());
+        CHECK(!catalog->might_be_outdated);
+        REQUIRE(catalog->entries.size() == 1);
+        CHECK(catalog->entries.at("c").file_path == "c.coollab");
+        CHECK(!catalog->entries.at("c").time_of_last_change.has_value());
+    }
+
+    // We crashed while writing a change
+    {
+        auto file = std::ofstream{catalog_path, std::ios::app};
+        file << R"({"Folder": "d", "Pa)";
+    }
+    CHECK(load_project_catalog(catalog_path, info_folder)->might_be_outdated);
+
+    // A project was added without us knowing
+    save_project_catalog(catalog_path, info_folder, load_project_catalog(catalog_path, info_folder)->entries);
+    CHECK(!load_project_catalog(catalog_path, info_folder)->might_be_outdated);
+    std::filesystem::last_write_time(info_folder, std::filesystem::last_write_time(info_folder) + std::chrono::seconds{10});
+    CHECK(load_project_catalog(catalog_path, info_folder)->might_be_outdated);
+
+    // A project was added without us knowing, and then we saved a change
+    save_project_catalog(catalog_path, info_folder, load_project_catalog(catalog_path, info_folder)->entries);
+    std::filesystem::last_write_time(info_folder, std::filesystem::last_write_time(info_folder) + std::chrono::seconds{10});
+    add_to_project_catalog(catalog_path, info_folder, folder_last_write_time(info_folder), "c", {"c.coollab", std::nullopt, std::nullopt}, std::nullopt);
+    CHECK(load_project_catalog(catalog_path, info_folder)->might_be_outdated);
+
+    Cool::File::remove_folder(folder);
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#include <map>
+#include "Version/VersionName.hpp"
+
+/// What the list of projects needs to know about a project, so that it doesn't have to read it from the disk
+struct ProjectCatalogEntry {
+    std::filesystem::path                          file_path{};
+    std::optional<std::filesystem::file_time_type> time_of_last_change{}; // The last write time of its path.txt, which Coollab rewrites each time it opens or saves the project, so we compare them to know if the entry is outdated. nullopt if it needs to be read from the disk again, e.g. because the project has been launched since we saved it
+    std::optional<VersionName>                     version{};
+};
+
+/// All the projects of the Projects Info folder, as we last saw them. It is saved to disk so that we don't have to read every folder in the Projects Info folder at startup.
+/// The file is a log: each change is appended as one line, so that saving a change is cheap, and a crash in the middle of a write can't corrupt the changes that were written before.
+struct ProjectCatalog {
+    std::map<std::string, ProjectCatalogEntry> entries{};          // By name of their folder in the Projects Info folder
+    bool                                       might_be_outdated{}; // True iff projects have been added to or removed from the Projects Info folder without us knowing (e.g. by Coollab), or if we lost some changes
+};
+
+/// Returns nullopt if we never saved the catalog, or if it can't be read
+auto load_project_catalog() -> std::optional<ProjectCatalog>;
+/// Rewrites the whole catalog
+void save_project_catalog(std::map<std::string, ProjectCatalogEntry> const& entries);
+/// Must be read before changing the Projects Info folder, and passed to add_to_project_catalog() / remove_from_project_catalog() once the change is done.
+/// This is how the catalog knows whether someone else (e.g. Coollab) changed the folder since the last time we saved it.
+auto projects_info_folder_last_write_time() -> std::optional<int64_t>;
+/// Must be called after the folder has been added to (or modified in) the Projects Info folder.
+/// If it replaces another folder (e.g. because the project has been renamed), pass the name of that other folder, so that both changes are saved at once.
+void add_to_project_catalog(std::optional<int64_t> folder_write_time_before_the_change, std::string const& folder_name, ProjectCatalogEntry const&, std::optional<std::string> const& replaced_folder_name = {});
+/// Must be called after the folder has been removed from the Projects Info folder
+void remove_from_project_catalog(std::optional<int64_t> folder_write_time_before_the_change, std::string const& folder_name);
@@ -1,5 +1,6 @@
 #include "ProjectManager.hpp"
 #include <filesystem>
+#include <span>
 #include <vector>
 #include "COOLLAB_FILE_EXTENSION.hpp"
 #include "Cool/File/File.h"
@@ -14,12 +15,61 @@
 #include "LongPaths/LongPathsChecker.hpp"
 #include "Path.hpp"
 #include "Project.hpp"
+#include "ProjectCatalog.hpp"
 #include "boxer/boxer.h"
 #include "imgui.h"
 #include "open/open.hpp"
 
-ProjectManager::ProjectManager()
+/// Each project needs a few accesses to the disk, and we spend most of the time waiting for them, so we do them in parallel
+template<typename Output, typename Input>
+static auto process_in_parallel(std::vector<Input> const& inputs, std::function<std::vector<Output>(std::span<Input const>)> const& process_batch) -> std::vector<Output>
+{
+    auto const nb_threads = std::clamp<size_t>(2 * std::thread::hardware_concurrency(), 4, 16);
+    auto const batch_size = (inputs.size() + nb_threads - 1) / nb_threads;
+    auto       workers    = std::vector<std::future<std::vector<Output>>>{};
+    for (size_t begin = 0; begin < inputs.size(); begin += batch_size)
+    {
+        workers.push_back(std::async(std::launch::async, [&, begin]() {
+            return process_batch(std::span{inputs}.subspan(begin, std::min(batch_size, inputs.size() - begin)));
+        }));
+    }
+
+    auto outputs = std::vector<Output>{};
+    outputs.reserve(inputs.size());
+    for (auto& worker : workers)
+    {
+        auto batch = worker.get();
+        outputs.insert(outputs.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    }
+    return outputs;
+}
+
+/// Reads the path.txt of each project, and everything that the list of projects will need to display them
+static auto load_projects(std::span<std::filesystem::path const> info_folders) -> std::vector<Project>
+{
+    auto projects = std::vector<Project>{};
+    for (auto const& info_folder : info_folders)
+    {
+        auto file = std::ifstream{info_folder / "path.txt"};
+        if (!file.is_open())
+        {
+            // TODO(Launcher) error
+            continue;
+        }
+        std::string path;
+        Cool::getline(file, path);
+        auto const& project = projects.emplace_back(path);
+        // Cache them now, because they each need to access the disk, which is slow if it is a network drive
+        project.time_of_last_change();
+        project.current_version();
+    }
+    return projects;
+}
+
+/// Looks at all the folders in the Projects Info folder. Slow when there are a lot of projects, so prefer the ProjectCatalog
+static auto scan_all_projects() -> std::vector<Project>
 {
+    auto info_folders = std::vector<std::filesystem::path>{};
     try
     {
         for (auto const& entry : std::filesystem::directory_iterator{Path::projects_info_folder()})
@@ -29,19 +79,7 @@ ProjectManager::ProjectManager()
                 assert(false);
                 continue;
             }
-
-            auto file = std::ifstream{entry.path() / "path.txt"};
-            if (!file.is_open())
-            {
-                // TODO(Launcher) error
-                continue;
-            }
-            std::string path;
-            Cool::getline(file, path);
-            _projects.emplace_back(path);
-#if defined(_WIN32)
-            long_paths_checker().check(path);
-#endif
+            info_folders.push_back(entry.path());
         }
     }
     catch (std::exception const&)
@@ -49,11 +87,98 @@ ProjectManager::ProjectManager()
         // TODO(Launcher) error
         // return fmt::format("{}", e.what());
     }
-    std::sort(_projects.begin(), _projects.end(), [](Project const& a, Project const& b) {
+
+    return process_in_parallel<Project, std::filesystem::path>(info_folders, &load_projects);
+}
+
+/// The name of its folder in the Projects Info folder, which is how the ProjectCatalog identifies it
+static auto catalog_key(Project const& project) -> std::string
+{
+    return project.info_folder_path().filename().string();
+}
+
+static auto catalog_entry(Project const& project) -> ProjectCatalogEntry
+{
+    return ProjectCatalogEntry{
+        .file_path           = project.file_path(),
+        .time_of_last_change = project.time_of_last_change(),
+        .version             = project.current_version(),
+    };
+}
+
+void mark_as_outdated_in_project_catalog(Project const& project)
+{
+    if (!Cool::File::exists(project.info_folder_path()))
+        return; // The project is not in the catalog yet. Coollab will add it to the Projects Info folder, and the catalog will notice that this folder changed
+    add_to_project_catalog(projects_info_folder_last_write_time(), catalog_key(project), ProjectCatalogEntry{.file_path = project.file_path()}); // We don't change the folder here
+}
+
+struct ProjectFromCatalog {
+    std::string folder_name;
+    Project     project;
+    bool        has_changed; // Since we saved it in the catalog
+};
+
+/// Only reads the projects that changed since we saved them in the catalog.
+/// Coollab rewrites the path.txt of a project each time it opens or saves it, which doesn't change the last write time of the Projects Info folder, so we need to check each path.txt
+static auto load_projects_from_catalog(std::span<std::pair<std::string, ProjectCatalogEntry> const> entries) -> std::vector<ProjectFromCatalog>
+{
+    auto projects = std::vector<ProjectFromCatalog>{};
+    for (auto const& [folder_name, entry] : entries)
+    {
+        auto       error_code      = std::error_code{};
+        auto const last_write_time = std::filesystem::last_write_time(Path::projects_info_folder() / folder_name / "path.txt", error_code); // This is what Project::time_of_last_change() reads
+        if (!error_code && entry.time_of_last_change == last_write_time)
+        {
+            projects.push_back({folder_name, Project{entry.file_path, *entry.time_of_last_change, entry.version}, false});
+        }
+        else
+        {
+            projects.push_back({folder_name, Project{entry.file_path}, true});
+            auto const& project = projects.back().project;
+            // Cache them now, because they each need to access the disk, which is slow if it is a network drive
+            project.time_of_last_change();
+            project.current_version();
+        }
+    }
+    return projects;
+}
+
+static auto load_all_projects() -> std::vector<Project>
+{
+    auto       projects = std::vector<Project>{};
+    auto const catalog  = load_project_catalog();
+    if (catalog.has_value() && !catalog->might_be_outdated)
+    {
+        auto const entries              = std::vector<std::pair<std::string, ProjectCatalogEntry>>{catalog->entries.begin(), catalog->entries.end()};
+        auto       projects_and_changes = process_in_parallel<ProjectFromCatalog, std::pair<std::string, ProjectCatalogEntry>>(entries, &load_projects_from_catalog);
+        projects.reserve(projects_and_changes.size());
+        for (auto& [folder_name, project, has_changed] : projects_and_changes)
+        {
+            if (has_changed)
+                add_to_project_catalog(projects_info_folder_last_write_time(), folder_name, catalog_entry(project)); // We don't change the folder here
+            projects.push_back(std::move(project));
+        }
+    }
+    else
+    {
+        // Some projects have been added or removed without us knowing (e.g. Coollab created a new project), so we need to look at the whole folder
+        projects     = scan_all_projects();
+        auto entries = std::map<std::string, ProjectCatalogEntry>{};
+        for (auto const& project : projects)
+            entries[catalog_key(project)] = catalog_entry(project);
+        save_project_catalog(entries);
+    }
+    std::sort(projects.begin(), projects.end(), [](Project const& a, Project const& b) {
         return a.time_of_last_change() > b.time_of_last_change();
     });
+    return projects;
 }
 
+ProjectManager::ProjectManager()
+    : _projects_being_loaded{std::async(std::launch::async, &load_all_projects)} // In the background, so that the first frames don't have to wait for it when there are a lot of projects
+{}
+
 static auto project_name_error_message(std::string const& name, std::string const& current_name, std::filesystem::path const& new_path) -> std::optional<std::string>
 {
     if (Cool::File::exists(new_path) && name != current_name)
@@ -95,6 +220,20 @@ static auto project_name_error_message(std::string const& name, std::string cons
 
 void ProjectManager::imgui(std::function<void(Project const&)> const& launch_project)
 {
+    if (_projects_being_loaded.valid())
+    {
+        if (_projects_being_loaded.wait_for(0s) != std::future_status::ready)
+        {
+            ImGui::TextDisabled("Loading projects...");
+            return;
+        }
+        _projects = _projects_being_loaded.get();
+#if defined(_WIN32)
+        for (auto const& project : _projects)
+            long_paths_checker().check(project.file_path());
+#endif
+    }
+
     auto project_to_remove = _projects.end();
     auto project_to_add    = std::optional<Project>{};
     for (auto it = _projects.begin(); it != _projects.end(); ++it)
@@ -162,9 +301,11 @@ void ProjectManager::imgui(std::function<void(Project const&)> const& launch_pro
                         if (!project_with_same_path.has_value())
                         {
                             auto const old_info_folder_path = project.info_folder_path();
+                            auto const folder_write_time    = projects_info_folder_last_write_time();
                             project.set_file_path(*path);
                             Cool::File::rename(old_info_folder_path, project.info_folder_path());
                             Cool::File::set_content(project.info_folder_path() / "path.txt", Cool::File::weakly_canonical(*path).string());
+                            add_to_project_catalog(folder_write_time, catalog_key(project), catalog_entry(project), old_info_folder_path.filename().string());
 #if defined(_WIN32)
                             long_paths_checker().check(project.file_path());
 #endif
@@ -203,8 +344,10 @@ void ProjectManager::imgui(std::function<void(Project const&)> const& launch_pro
 
                     project_to_add = Project{new_path};
 
+                    auto const folder_write_time = projects_info_folder_last_write_time();
                     Cool::File::copy_file(project.info_folder_path() / "thumbnail.png", project_to_add->info_folder_path() / "thumbnail.png");
                     Cool::File::set_content(project_to_add->info_folder_path() / "path.txt", Cool::File::weakly_canonical(new_path).string());
+                    add_to_project_catalog(folder_write_time, catalog_key(*project_to_add), catalog_entry(*project_to_add));
 #if defined(_WIN32)
                     long_paths_checker().check(project_to_add->file_path());
 #endif
@@ -216,8 +359,10 @@ void ProjectManager::imgui(std::function<void(Project const&)> const& launch_pro
             {
                 if (boxer::Selection::OK == boxer::show("Are you sure? This cannot be undone", fmt::format("Deleting project \"{}\"", project.name()).c_str(), boxer::Style::Warning, boxer::Buttons::OKCancel))
                 {
+                    auto const folder_write_time = projects_info_folder_last_write_time();
                     Cool::File::remove_folder(project.info_folder_path());
                     Cool::File::remove_file(project.file_path());
+                    remove_from_project_catalog(folder_write_time, catalog_key(project));
                     project_to_remove = it;
                 }
             }
@@ -262,9 +407,11 @@ void ProjectManager::imgui(std::function<void(Project const&)> const& launch_pro
                         auto const old_info_folder = project.info_folder_path();
                         if (Cool::File::rename(project.file_path(), new_path))
                         {
+                            auto const folder_write_time = projects_info_folder_last_write_time();
                             project.set_file_path(new_path);
                             Cool::File::rename(old_info_folder, project.info_folder_path());
                             Cool::File::set_content(project.info_folder_path() / "path.txt", Cool::File::weakly_canonical(new_path).string());
+                            add_to_project_catalog(folder_write_time, catalog_key(project), catalog_entry(project), old_info_folder.filename().string());
 #if defined(_WIN32)
                             long_paths_checker().check(new_path);
 #endif
@@ -1,4 +1,5 @@
 #pragma once
+#include <future>
 #include "Cool/CheckerboardTexture/CheckerboardTexture.hpp"
 #include "Project.hpp"
 
@@ -9,6 +10,10 @@ public:
     void imgui(std::function<void(Project const&)> const& launch_project);
 
 private:
-    std::vector<Project>      _projects{};
-    Cool::CheckerboardTexture _checkerboard_texture{};
-};
\ No newline at end of file
+    std::vector<Project>              _projects{};
+    std::future<std::vector<Project>> _projects_being_loaded{}; // Valid until the projects have finished loading
+    Cool::CheckerboardTexture         _checkerboard_texture{};
+};
+
+/// Must be called whenever a project is launched (from the list, by double-clicking on its file, etc.): Coollab is going to modify the project, so the ProjectCatalog will need to read it again next time
+void mark_as_outdated_in_project_catalog(Project const&);
\ No newline at end of file
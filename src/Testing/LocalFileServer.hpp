@@ -0,0 +1,52 @@
+#pragma once
+#include "httplib.h"
+
+/// Serves a file with support for Range requests and If-None-Match, like GitHub does for the release assets
+/// Only used by the tests
+class LocalFileServer {
+public:
+    /// If `delay_between_chunks` is not 0, the content is sent slowly, chunk by chunk, to simulate a real network
+    explicit LocalFileServer(std::string content, std::chrono::milliseconds delay_between_chunks = 0ms)
+        : _content{std::move(content)}
+    {
+        _server.Get(".*", [&, delay_between_chunks](httplib::Request const& req, httplib::Response& res) { // Match any path because make_http_request() sends the full url as the path
+            res.set_header("Accept-Ranges", "bytes");
+            res.set_header("ETag", "\"local-file\"");
+            if (req.get_header_value("If-None-Match") == "\"local-file\"")
+            {
+                res.status = 304;
+                return;
+            }
+            if (delay_between_chunks == 0ms)
+            {
+                res.set_content(_content, "application/octet-stream");
+                return;
+            }
+            res.set_content_provider(_content.size(), "application/octet-stream", [&, delay_between_chunks](size_t offset, size_t length, httplib::DataSink& sink) {
+                static constexpr size_t chunk_size{64'000};
+                std::this_thread::sleep_for(delay_between_chunks);
+                return sink.write(_content.data() + offset, std::min(length, chunk_size)); // NOLINT(*pointer-arithmetic)
+            });
+        });
+        _port   = _server.bind_to_any_port("127.0.0.1");
+        _thread = std::thread{[&]() { _server.listen_after_bind(); }};
+        _server.wait_until_ready();
+    }
+    ~LocalFileServer()
+    {
+        _server.stop();
+        _thread.join();
+    }
+    LocalFileServer(LocalFileServer const&)                = delete;
+    LocalFileServer& operator=(LocalFileServer const&)     = delete;
+    LocalFileServer(LocalFileServer&&) noexcept            = delete;
+    LocalFileServer& operator=(LocalFileServer&&) noexcept = delete;
+
+    auto url() const -> std::string { return fmt::format("http://127.0.0.1:{}/asset", _port); }
+
+private:
+    std::string     _content;
+    httplib::Server _server{};
+    int             _port{};
+    std::thread     _thread{};
+};
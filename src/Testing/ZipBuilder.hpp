@@ -0,0 +1,107 @@
+#pragma once
+#include "mz.h"
+#include "mz_crypt.h"
+
+/// Builds a zip in memory. Only used by the tests.
+/// minizip is compiled in decompress-only mode, so the deflated entries need to be compressed beforehand
+class ZipBuilder {
+public:
+    struct Entry {
+        std::string name{};
+        std::string content{};
+        std::string compressed_content{}; // Empty if the entry is stored without compression
+        bool        has_data_descriptor{false};
+        uint32_t    unix_permissions{0644};
+    };
+
+    void add(Entry entry) { _entries.push_back(std::move(entry)); }
+
+    auto build() const -> std::string
+    {
+        auto zip     = std::string{};
+        auto offsets = std::vector<uint32_t>{};
+        for (auto const& entry : _entries)
+        {
+            offsets.push_back(static_cast<uint32_t>(zip.size()));
+            auto const has_descriptor = entry.has_data_descriptor;
+            write_u32(zip, 0x04034b50);
+            write_u16(zip, 20);                                                              // Version needed to extract
+            write_u16(zip, static_cast<uint16_t>(has_descriptor ? (1 << 3) : 0));            // Flags
+            write_u16(zip, static_cast<uint16_t>(entry.compressed_content.empty() ? 0 : 8)); // Compression method: stored or deflate
+            write_u16(zip, 0);                                                               // Time
+            write_u16(zip, 0x21);                                                            // Date (1980-01-01)
+            write_u32(zip, has_descriptor ? 0 : crc(entry));
+            write_u32(zip, has_descriptor ? 0 : compressed_size(entry));
+            write_u32(zip, has_descriptor ? 0 : static_cast<uint32_t>(entry.content.size()));
+            write_u16(zip, static_cast<uint16_t>(entry.name.size()));
+            write_u16(zip, 0); // Extra field length
+            zip += entry.name;
+            zip += entry.compressed_content.empty() ? entry.content : entry.compressed_content;
+            if (has_descriptor)
+            {
+                write_u32(zip, 0x08074b50);
+                write_u32(zip, crc(entry));
+                write_u32(zip, compressed_size(entry));
+                write_u32(zip, static_cast<uint32_t>(entry.content.size()));
+            }
+        }
+
+        auto const central_directory_offset = static_cast<uint32_t>(zip.size());
+        for (size_t i = 0; i < _entries.size(); ++i)
+        {
+            auto const& entry = _entries[i];
+            write_u32(zip, 0x02014b50);
+            write_u16(zip, (3 << 8) | 20); // Made by unix
+            write_u16(zip, 20);
+            write_u16(zip, static_cast<uint16_t>(entry.has_data_descriptor ? (1 << 3) : 0));
+            write_u16(zip, static_cast<uint16_t>(entry.compressed_content.empty() ? 0 : 8)); // Compression method: stored or deflate
+            write_u16(zip, 0);
+            write_u16(zip, 0x21);
+            write_u32(zip, crc(entry));
+            write_u32(zip, compressed_size(entry));
+            write_u32(zip, static_cast<uint32_t>(entry.content.size()));
+            write_u16(zip, static_cast<uint16_t>(entry.name.size()));
+            write_u16(zip, 0); // Extra field length
+            write_u16(zip, 0); // Comment length
+            write_u16(zip, 0); // Disk number
+            write_u16(zip, 0); // Internal attributes
+            write_u32(zip, (entry.name.ends_with('/') ? 0040755u : 0100000u | entry.unix_permissions) << 16);
+            write_u32(zip, offsets[i]);
+            zip += entry.name;
+        }
+        auto const central_directory_size = static_cast<uint32_t>(zip.size()) - central_directory_offset;
+
+        write_u32(zip, 0x06054b50);
+        write_u16(zip, 0);
+        write_u16(zip, 0);
+        write_u16(zip, static_cast<uint16_t>(_entries.size()));
+        write_u16(zip, static_cast<uint16_t>(_entries.size()));
+        write_u32(zip, central_directory_size);
+        write_u32(zip, central_directory_offset);
+        write_u16(zip, 0); // Comment length
+        return zip;
+    }
+
+private:
+    static void write_u16(std::string& zip, uint16_t value)
+    {
+        zip += static_cast<char>(value & 0xFF);
+        zip += static_cast<char>(value >> 8);
+    }
+    static void write_u32(std::string& zip, uint32_t value)
+    {
+        write_u16(zip, static_cast<uint16_t>(value & 0xFFFF));
+        write_u16(zip, static_cast<uint16_t>(value >> 16));
+    }
+    static auto crc(Entry const& entry) -> uint32_t
+    {
+        return mz_crypt_crc32_update(0, reinterpret_cast<uint8_t const*>(entry.content.data()), static_cast<int32_t>(entry.content.size())); // NOLINT(*reinterpret-cast)
+    }
+    static auto compressed_size(Entry const& entry) -> uint32_t
+    {
+        return static_cast<uint32_t>(entry.compressed_content.empty() ? entry.content.size() : entry.compressed_content.size());
+    }
+
+private:
+    std::vector<Entry> _entries{};
+};
@@ -0,0 +1,139 @@
+#include "InstallScheduler.hpp"
+#include <thread>
+
+void InstallScheduler::Ticket::raise_priority_to(InstallPriority priority)
+{
+    auto current = _priority.load();
+    while (current < priority && !_priority.compare_exchange_weak(current, priority))
+    {
+    }
+}
+
+auto InstallScheduler::make_ticket(InstallPriority priority) -> std::shared_ptr<Ticket>
+{
+    auto lock   = std::unique_lock{_mutex};
+    auto ticket = std::make_shared<Ticket>(priority, _next_order++);
+    std::erase_if(_tickets, [](std::weak_ptr<Ticket> const& ticket) { return ticket.expired(); });
+    _tickets.push_back(ticket);
+    return ticket;
+}
+
+auto InstallScheduler::nb_running(InstallPriority priority) const -> size_t
+{
+    auto res = size_t{0};
+    for (auto const& weak_ticket : _tickets)
+    {
+        auto const ticket = weak_ticket.lock();
+        if (ticket && ticket->_is_running && !ticket->_is_finished && ticket->priority() >= priority)
+            res++;
+    }
+    return res;
+}
+
+auto InstallScheduler::try_start(Ticket& ticket) -> bool
+{
+    auto const max_nb_of_concurrent_installs = std::max(_get_limits().max_nb_of_concurrent_installs, size_t{1}); // Before locking, because we don't know how long it takes to get the limits
+    auto       lock                          = std::unique_lock{_mutex};
+    if (ticket._is_running || ticket._is_finished)
+        return ticket._is_running;
+
+    auto const priority = ticket.priority();
+    // User-initiated installs don't wait for the background ones, they only wait for each other
+    if (nb_running(priority) >= max_nb_of_concurrent_installs)
+        return false;
+    for (auto const& weak_other : _tickets)
+    {
+        auto const other = weak_other.lock();
+        if (!other || other.get() == &ticket || other->_is_running || other->_is_finished)
+            continue;
+        auto const other_priority = other->priority();
+        if (other_priority > priority || (other_priority == priority && other->_order < ticket._order)) // Someone more important is waiting
+            return false;
+    }
+    ticket._is_running = true;
+    return true;
+}
+
+void InstallScheduler::finish(Ticket& ticket)
+{
+    auto lock           = std::unique_lock{_mutex};
+    ticket._is_finished = true;
+}
+
+void InstallScheduler::throttle(Ticket const& ticket, uint64_t nb_bytes)
+{
+    auto const bytes_per_second = _get_limits().background_bandwidth_limit;
+    if (ticket.priority() != InstallPriority::Background || bytes_per_second == 0)
+        return;
+
+    auto duration_to_wait = std::chrono::steady_clock::duration{};
+    {
+        auto       lock         = std::unique_lock{_mutex};
+        auto const now          = std::chrono::steady_clock::now();
+        _bandwidth_available_at = std::max(_bandwidth_available_at, now - 1s); // Don't accumulate more than 1 second of unused budget while nothing was downloading
+        _bandwidth_available_at += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>{static_cast<double>(nb_bytes) / static_cast<double>(bytes_per_second)});
+        duration_to_wait = _bandwidth_available_at - now;
+    }
+    // Not reading from the connection makes the server slow down, so this limits the bandwidth we actually use, not only the speed at which we write to the disk
+    if (duration_to_wait > std::chrono::steady_clock::duration::zero())
+        std::this_thread::sleep_for(duration_to_wait);
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+
+TEST_CASE("Install scheduler")
+{
+    for (size_t const max : {size_t{1}, size_t{2}})
+    {
+        auto scheduler = InstallScheduler{[&]() {
+            return InstallScheduler::Limits{.max_nb_of_concurrent_installs = max};
+        }};
+
+        auto background = std::vector<std::shared_ptr<InstallScheduler::Ticket>>{};
+        for (size_t i = 0; i < max + 1; ++i)
+            background.push_back(scheduler.make_ticket(InstallPriority::Background));
+        for (size_t i = 0; i < max; ++i)
+            CHECK(scheduler.try_start(*background[i]));
+        CHECK(!scheduler.try_start(*background[max])); // No slot left
+
+        // User-initiated installs don't wait for the background ones
+        auto const user = scheduler.make_ticket(InstallPriority::UserInitiated);
+        CHECK(scheduler.try_start(*user));
+
+        // A background install finishes, but the slot goes to the user-initiated installs first
+        auto const user_2 = scheduler.make_ticket(InstallPriority::UserInitiated);
+        scheduler.finish(*background[0]);
+        if (max == 1)
+            CHECK(!scheduler.try_start(*user_2)); // Waits for the other user-initiated install
+        CHECK(!scheduler.try_start(*background[max]));
+        scheduler.finish(*user);
+        CHECK(scheduler.try_start(*user_2));
+        scheduler.finish(*user_2);
+        CHECK(scheduler.try_start(*background[max]));
+
+        // Installs that have been abandoned don't block the others
+        auto const late = scheduler.make_ticket(InstallPriority::Background);
+        background.clear();
+        CHECK(scheduler.try_start(*late));
+    }
+}
+
+TEST_CASE("Bandwidth budget of the background installs")
+{
+    auto scheduler = InstallScheduler{[]() {
+        return InstallScheduler::Limits{.background_bandwidth_limit = 1'000'000};
+    }};
+    auto const background     = scheduler.make_ticket(InstallPriority::Background);
+    auto const user_initiated = scheduler.make_ticket(InstallPriority::UserInitiated);
+
+    auto const duration_to_download = [&](InstallScheduler::Ticket const& ticket) {
+        auto const begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < 150; ++i)
+            scheduler.throttle(ticket, 10'000);
+        return std::chrono::steady_clock::now() - begin;
+    };
+    CHECK(duration_to_download(*user_initiated) < 100ms);
+    CHECK(duration_to_download(*background) > 400ms); // 1.5 MB at 1 MB/s, minus the 1 second of budget we start with
+}
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+#include <mutex>
+#include "LauncherSettings.hpp"
+
+/// Ordered from least to most important
+enum class InstallPriority : uint8_t {
+    Background,    // e.g. automatically installing the latest version
+    UserInitiated, // The user is waiting for it, e.g. to open a project
+};
+
+/// Decides when each install can start, so that background installs don't compete with the ones the user is waiting for:
+/// - At most `Limits::max_nb_of_concurrent_installs` installs of each priority run at the same time, and background installs only start when no user-initiated install is waiting
+/// - Background installs share a global bandwidth budget, so that they don't saturate the network
+class InstallScheduler {
+public:
+    struct Limits {
+        size_t   max_nb_of_concurrent_installs{1};
+        uint64_t background_bandwidth_limit{0}; // In bytes per second, 0 means no limit
+    };
+
+    /// `get_limits` is called each time we need the limits, so that they can change while installs are running. It can be called from any thread
+    explicit InstallScheduler(std::function<Limits()> get_limits)
+        : _get_limits{std::move(get_limits)}
+    {}
+
+    class Ticket {
+    public:
+        Ticket(InstallPriority priority, uint64_t order)
+            : _priority{priority}, _order{order}
+        {}
+        ~Ticket()                            = default; // Doesn't need to call finish(): the scheduler ignores the tickets that have been destroyed. (And it couldn't, because the scheduler can destroy a ticket while its mutex is locked, if it was holding the last reference to it)
+        Ticket(Ticket const&)                = delete;
+        Ticket& operator=(Ticket const&)     = delete;
+        Ticket(Ticket&&) noexcept            = delete;
+        Ticket& operator=(Ticket&&) noexcept = delete;
+
+        /// e.g. when the user wants to launch a version that was being installed in the background
+        void raise_priority_to(InstallPriority priority);
+        auto priority() const -> InstallPriority { return _priority.load(); }
+
+    private:
+        friend class InstallScheduler;
+        std::atomic<InstallPriority> _priority;
+        uint64_t                     _order; // Installs of the same priority start in the order they were requested
+        bool                         _is_running{false};
+        bool                         _is_finished{false};
+    };
+
+    /// Each install must keep its ticket alive until it finishes
+    auto make_ticket(InstallPriority) -> std::shared_ptr<Ticket>;
+    /// Returns true if the install can start now, in which case it takes one of the slots until finish() is called
+    auto try_start(Ticket&) -> bool;
+    /// Gives the slot of the install to the next one. Destroying the ticket has the same effect
+    void finish(Ticket&);
+    /// Must be called for each chunk that an install downloads. Blocks the background installs as long as needed to respect the bandwidth budget
+    void throttle(Ticket const&, uint64_t nb_bytes);
+
+private:
+    auto nb_running(InstallPriority) const -> size_t;
+
+private:
+    std::function<Limits()>               _get_limits;
+    std::mutex                            _mutex{};
+    std::vector<std::weak_ptr<Ticket>>    _tickets{}; // Both waiting and running
+    uint64_t                              _next_order{0};
+    std::chrono::steady_clock::time_point _bandwidth_available_at{}; // Each byte downloaded by a background install "consumes" some time. If this is in the future, the budget is exceeded
+};
+
+inline auto install_scheduler() -> InstallScheduler&
+{
+    static auto instance = InstallScheduler{[]() {
+        return InstallScheduler::Limits{
+            .max_nb_of_concurrent_installs = launcher_settings().max_nb_of_concurrent_installs(),
+            .background_bandwidth_limit    = launcher_settings().background_installs_bandwidth_limit_in_bytes_per_second(),
+        };
+    }};
+    return instance;
+}
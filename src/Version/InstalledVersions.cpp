@@ -0,0 +1,124 @@
+#include "InstalledVersions.hpp"
+#include <fstream>
+#include "Cool/File/File.h"
+#include "Cool/Serialization/Json.hpp"
+#include "FolderLastWriteTime/folder_last_write_time.hpp"
+#include "Path.hpp"
+#include "nlohmann/json.hpp"
+
+static auto load_installed_versions(std::filesystem::path const& list_path, std::filesystem::path const& installation_folder) -> std::optional<InstalledVersions>
+{
+    auto file = std::ifstream{list_path};
+    if (!file.is_open())
+        return std::nullopt;
+
+    try
+    {
+        auto const json              = nlohmann::json::parse(file);
+        auto       installed         = InstalledVersions{};
+        auto       folder_write_time = int64_t{};
+        Cool::json_get(json, "Folder last write time", folder_write_time);
+        for (auto const& name : json.at("Versions"))
+        {
+            auto version_name = VersionName::from(name.get<std::string>());
+            if (version_name.has_value())
+                installed.versions.push_back(std::move(*version_name));
+        }
+        installed.might_be_outdated = folder_last_write_time(installation_folder) != folder_write_time;
+        return installed;
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Load installed versions", e.what());
+        return std::nullopt;
+    }
+}
+
+static void save_installed_versions(std::filesystem::path const& list_path, std::filesystem::path const& installation_folder, std::vector<VersionName> const& versions)
+{
+    std::ignore = Cool::File::create_folders_for_file_if_they_dont_exist(list_path); // Before reading the last write time, because creating a folder in the installation folder modifies it
+
+    auto json = nlohmann::json{};
+    Cool::json_set(json, "Folder last write time", folder_last_write_time(installation_folder).value_or(0));
+    auto names = nlohmann::json::array();
+    for (auto const& version : versions)
+        names.push_back(version.as_string_raw());
+    json["Versions"] = std::move(names);
+    Cool::File::set_content(list_path, json.dump());
+}
+
+static auto scan_installed_versions(std::filesystem::path const& installation_folder) -> std::vector<VersionName>
+{
+    auto versions = std::vector<VersionName>{};
+    try
+    {
+        for (auto const& entry : std::filesystem::directory_iterator{installation_folder})
+        {
+            try
+            {
+                if (!entry.is_directory())
+                    continue;
+                auto version_name = VersionName::from(entry.path().filename().string()); // Use filename() and not stem(), because stem() would stop at the first dot (e.g. "folder/19.0.3" would become "19" instead of "19.0.3"). Also, folders that start with a dot (e.g. ".Downloads") are not valid version names
+                if (version_name.has_value())
+                    versions.push_back(std::move(*version_name));
+            }
+            catch (std::exception const& e)
+            {
+                Cool::Log::internal_error("Get all locally installed versions", e.what());
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_error("Get all locally installed versions", e.what());
+    }
+    std::sort(versions.begin(), versions.end());
+    return versions;
+}
+
+auto load_installed_versions() -> std::optional<InstalledVersions>
+{
+    return load_installed_versions(Path::installed_versions_list_file(), Path::installed_versions_folder());
+}
+
+void save_installed_versions(std::vector<VersionName> const& versions)
+{
+    save_installed_versions(Path::installed_versions_list_file(), Path::installed_versions_folder(), versions);
+}
+
+auto scan_installed_versions() -> std::vector<VersionName>
+{
+    return scan_installed_versions(Path::installed_versions_folder());
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+
+TEST_CASE("List of installed versions")
+{
+    auto const folder    = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "installed_versions";
+    auto const list_path = folder / ".Manifests" / "Installed versions.json";
+    Cool::File::remove_folder(folder);
+    Cool::File::set_content(folder / "1.2.0" / "Coollab", "");
+    Cool::File::set_content(folder / "1.1.0" / "Coollab", "");
+    Cool::File::set_content(folder / ".Downloads" / "1.3.0", "");
+
+    auto const versions = scan_installed_versions(folder);
+    REQUIRE(versions.size() == 2);
+    CHECK(versions[0] == *VersionName::from("1.1.0"));
+    CHECK(versions[1] == *VersionName::from("1.2.0"));
+
+    CHECK(!load_installed_versions(list_path, folder).has_value());
+    save_installed_versions(list_path, folder, versions);
+    auto const installed = load_installed_versions(list_path, folder);
+    REQUIRE(installed.has_value());
+    CHECK(installed->versions == versions);
+    CHECK(!installed->might_be_outdated);
+
+    // Pretend the folder was modified after we saved the list
+    std::filesystem::last_write_time(folder, std::filesystem::last_write_time(folder) + std::chrono::seconds{10});
+    CHECK(load_installed_versions(list_path, folder)->might_be_outdated);
+
+    Cool::File::remove_folder(folder);
+}
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+#include "VersionName.hpp"
+
+/// The versions that are installed, as we last saw them. It is saved to disk so that we don't have to scan the installation folder at startup.
+struct InstalledVersions {
+    std::vector<VersionName> versions{};
+    bool                     might_be_outdated{}; // True iff the installation folder has been modified since we saved the list (e.g. the user deleted a version manually)
+};
+
+/// Returns nullopt if we never saved the list, or if it can't be read
+auto load_installed_versions() -> std::optional<InstalledVersions>;
+void save_installed_versions(std::vector<VersionName> const&);
+/// Looks at all the folders in the installation folder. Slow-ish, so prefer load_installed_versions()
+/// The result is sorted
+auto scan_installed_versions() -> std::vector<VersionName>;
@@ -0,0 +1,160 @@
+#include "ReleaseCatalog.hpp"
+#include <fstream>
+#include "Cool/File/File.h"
+#include "Cool/Serialization/Json.hpp"
+#include "Path.hpp"
+#include "nlohmann/json.hpp"
+
+static auto is_newer(ReleaseCatalog::Release const& a, ReleaseCatalog::Release const& b) -> bool
+{
+    return a.name > b.name;
+}
+
+auto ReleaseCatalog::contains(VersionName const& name) const -> bool
+{
+    return std::binary_search(releases.begin(), releases.end(), Release{name}, &is_newer);
+}
+
+void sort_releases(std::vector<ReleaseCatalog::Release>& releases)
+{
+    std::stable_sort(releases.begin(), releases.end(), &is_newer); // Stable, so that when there are duplicates we keep the first one
+    releases.erase(std::unique(releases.begin(), releases.end(), [](ReleaseCatalog::Release const& a, ReleaseCatalog::Release const& b) { return a.name == b.name; }), releases.end()); // Two releases with the same name would be the same version for us
+}
+
+auto merge_releases(std::vector<ReleaseCatalog::Release> fetched_releases, std::vector<ReleaseCatalog::Release> const& previous_releases) -> std::vector<ReleaseCatalog::Release>
+{
+    fetched_releases.insert(fetched_releases.end(), previous_releases.begin(), previous_releases.end()); // After the fetched ones, so that they are the ones we keep when removing duplicates
+    sort_releases(fetched_releases);
+    return fetched_releases;
+}
+
+static auto optional_string(nlohmann::json const& json) -> std::optional<std::string>
+{
+    if (json.is_null())
+        return std::nullopt;
+    return json.get<std::string>();
+}
+
+static auto load_release_catalog(std::filesystem::path const& path) -> std::optional<ReleaseCatalog>
+{
+    auto file = std::ifstream{path};
+    if (!file.is_open())
+        return std::nullopt;
+
+    try
+    {
+        auto const json       = nlohmann::json::parse(file);
+        auto       catalog    = ReleaseCatalog{};
+        auto       fetch_time = int64_t{};
+        Cool::json_get(json, "Fetch time", fetch_time);
+        catalog.fetch_time = std::chrono::system_clock::time_point{std::chrono::seconds{fetch_time}};
+        for (auto const& release_json : json.at("Releases"))
+        {
+            auto const name = VersionName::from(release_json.at(0).get<std::string>());
+            if (!name.has_value())
+                continue;
+            catalog.releases.push_back(ReleaseCatalog::Release{
+                .name          = *name,
+                .download_url  = release_json.at(1).get<std::string>(),
+                .changelog_url = release_json.at(2).get<std::string>(),
+                .zsync_url     = optional_string(release_json.at(3)),
+                .sha256        = optional_string(release_json.at(4)),
+            });
+        }
+        sort_releases(catalog.releases); // The file might not be sorted the way we expect (e.g. it was edited by hand, or saved by an older version of the launcher)
+        return catalog;
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Load release catalog", e.what());
+        return std::nullopt;
+    }
+}
+
+static void save_release_catalog(std::filesystem::path const& path, ReleaseCatalog const& catalog)
+{
+    auto json = nlohmann::json{};
+    Cool::json_set(json, "Fetch time", static_cast<int64_t>(std::chrono::duration_cast<std::chrono::seconds>(catalog.fetch_time.time_since_epoch()).count()));
+    auto releases = nlohmann::json::array();
+    for (auto const& release : catalog.releases)
+    {
+        releases.push_back({
+            release.name.as_string_raw(),
+            release.download_url,
+            release.changelog_url,
+            release.zsync_url ? nlohmann::json(*release.zsync_url) : nlohmann::json(nullptr),
+            release.sha256 ? nlohmann::json(*release.sha256) : nlohmann::json(nullptr),
+        });
+    }
+    json["Releases"] = std::move(releases);
+    Cool::File::set_content(path, json.dump());
+}
+
+auto load_release_catalog() -> std::optional<ReleaseCatalog>
+{
+    return load_release_catalog(Path::release_catalog_file());
+}
+
+void save_release_catalog(ReleaseCatalog const& catalog)
+{
+    save_release_catalog(Path::release_catalog_file(), catalog);
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+
+TEST_CASE("Release catalog can be saved and loaded")
+{
+    auto const path    = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "release_catalog.json";
+    auto       catalog = ReleaseCatalog{};
+    catalog.fetch_time = std::chrono::system_clock::time_point{std::chrono::seconds{1'700'000'000}};
+    catalog.releases.push_back({*VersionName::from("1.2.0"), "https://example.com/1.2.0/Coollab.AppImage", "https://example.com/1.2.0/changelog.md", "https://example.com/1.2.0/Coollab.AppImage.zsync", "abcdef"});
+    catalog.releases.push_back({*VersionName::from("1.1.0 MacOS"), "https://example.com/1.1.0/Coollab.AppImage", "https://example.com/1.1.0/changelog.md", std::nullopt, std::nullopt});
+    save_release_catalog(path, catalog);
+
+    auto const loaded = load_release_catalog(path);
+    REQUIRE(loaded.has_value());
+    CHECK(loaded->fetch_time == catalog.fetch_time);
+    REQUIRE(loaded->releases.size() == 2);
+    CHECK(loaded->releases[0].name == *VersionName::from("1.2.0"));
+    CHECK(loaded->releases[0].zsync_url == "https://example.com/1.2.0/Coollab.AppImage.zsync");
+    CHECK(loaded->releases[0].sha256 == "abcdef");
+    CHECK(loaded->releases[1].name.as_string_raw() == "1.1.0 MacOS");
+    CHECK(loaded->releases[1].download_url == "https://example.com/1.1.0/Coollab.AppImage");
+    CHECK(!loaded->releases[1].zsync_url.has_value());
+    CHECK(!loaded->releases[1].sha256.has_value());
+
+    // Whatever the order in the file, the loaded releases are sorted from latest to oldest
+    std::swap(catalog.releases[0], catalog.releases[1]);
+    save_release_catalog(path, catalog);
+    auto const reloaded = load_release_catalog(path);
+    REQUIRE(reloaded.has_value());
+    REQUIRE(reloaded->releases.size() == 2);
+    CHECK(reloaded->releases[0].name == *VersionName::from("1.2.0"));
+    CHECK(reloaded->releases[1].name == *VersionName::from("1.1.0 MacOS"));
+    CHECK(reloaded->contains(*VersionName::from("1.1.0 MacOS")));
+
+    Cool::File::remove_file(path);
+    CHECK(!load_release_catalog(path).has_value());
+}
+
+TEST_CASE("Merging the releases we fetched with the ones we already knew")
+{
+    auto const release = [](std::string const& name, std::string const& download_url) {
+        return ReleaseCatalog::Release{*VersionName::from(name), download_url};
+    };
+    auto const merged = merge_releases(
+        {release("1.3.0", "new"), release("1.2.0", "new")},
+        {release("1.2.0", "old"), release("1.1.0", "old")}
+    );
+    REQUIRE(merged.size() == 3);
+    CHECK(merged[0].name == *VersionName::from("1.3.0"));
+    CHECK(merged[1].name == *VersionName::from("1.2.0"));
+    CHECK(merged[1].download_url == "new");
+    CHECK(merged[2].name == *VersionName::from("1.1.0"));
+
+    auto const catalog = ReleaseCatalog{.releases = merged};
+    CHECK(catalog.contains(*VersionName::from("1.2.0")));
+    CHECK(!catalog.contains(*VersionName::from("1.2.1")));
+}
+#endif
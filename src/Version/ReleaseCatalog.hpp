@@ -0,0 +1,28 @@
+#pragma once
+#include "VersionName.hpp"
+
+/// The releases that are available online, as we parsed them the last time we fetched them.
+/// It is saved to disk, so that at startup we know about them immediately, even without an Internet connection, and fetching the list only refreshes it.
+struct ReleaseCatalog {
+    struct Release {
+        VersionName                name;
+        std::string                download_url{};
+        std::string                changelog_url{};
+        std::optional<std::string> zsync_url{};
+        std::optional<std::string> sha256{};
+    };
+
+    std::vector<Release>                  releases{}; // Sorted, from latest to oldest version
+    std::chrono::system_clock::time_point fetch_time{}; // Last time we fetched all the releases (and not just the most recent ones)
+
+    auto contains(VersionName const&) const -> bool;
+};
+
+/// Sorts from latest to oldest version, and removes the duplicates
+void sort_releases(std::vector<ReleaseCatalog::Release>&);
+/// When we only fetched the most recent releases, the older ones are taken from the previous catalog
+auto merge_releases(std::vector<ReleaseCatalog::Release> fetched_releases, std::vector<ReleaseCatalog::Release> const& previous_releases) -> std::vector<ReleaseCatalog::Release>;
+
+/// Returns nullopt if we never saved a catalog, or if it can't be read
+auto load_release_catalog() -> std::optional<ReleaseCatalog>;
+void save_release_catalog(ReleaseCatalog const&);
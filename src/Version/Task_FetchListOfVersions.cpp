@@ -1,10 +1,12 @@
 #include "Task_FetchListOfVersions.hpp"
 #include "Cool/ImGui/markdown.h"
 #include "Cool/Task/TaskManager.hpp"
+#include "Path.hpp"
+#include "ReleaseCatalog.hpp"
 #include "Status.hpp"
 #include "VersionManager.hpp"
 #include "make_http_request.hpp"
-#include "nlohmann/json.hpp"
+#include "parse_releases.hpp"
 #include "suggest_dl_from_github.hpp"
 
 static auto asset_name_for_current_os() -> std::string
@@ -20,58 +22,61 @@ static auto asset_name_for_current_os() -> std::string
 #endif
 }
 
+/// Even when we have a recent catalog, we fetch all the releases from time to time, to notice the ones that have been modified or removed
+static constexpr auto full_fetch_interval = std::chrono::days{7};
+
 auto Task_FetchListOfVersions::execute() -> Cool::TaskCoroutine
 {
-    auto const res = make_http_request("https://api.github.com/repos/Coollab-Art/Coollab/releases", [&](uint64_t, uint64_t) {
-        return !has_been_canceled();
-    });
+    // Github lists the releases from the most recent one, so if we have a recent catalog we only need to fetch until we reach a release that we already know
+    auto const previous_catalog = load_release_catalog();
+    auto const is_incremental   = previous_catalog.has_value() && std::chrono::system_clock::now() - previous_catalog->fetch_time < full_fetch_interval;
 
-    if (!res || res->status != 200)
+    auto releases = std::vector<ReleaseCatalog::Release>{};
+    auto url      = std::make_optional(fmt::format("https://api.github.com/repos/Coollab-Art/Coollab/releases?per_page={}", is_incremental ? 10 : 100)); // 100 is the max allowed by Github
+    for (auto is_first_page = true; url.has_value(); is_first_page = false)
     {
-        handle_error(res);
-        co_return;
-    }
+        auto const progress = [&](uint64_t, uint64_t) {
+            return !has_been_canceled();
+        };
+        // If the first page hasn't changed since the last time, we get a 304 and the body is the one we cached
+        auto const res = is_first_page
+                             ? make_conditional_http_request(*url, Path::releases_list_file(), progress)
+                             : make_http_request(*url, progress);
 
-    try
-    {
-        auto const json_response = nlohmann::json::parse(res->body);
-        for (auto const& version_json : json_response)
+        if (!res || (res->status != 200 && res->status != 304))
         {
-            if (has_been_canceled())
-                co_return;
-
-            try
-            {
-                if (version_json.at("draft") == true)
-                    continue;
-
-                auto const version_name = VersionName::from(version_json.at("name"));
-                if (!version_name.has_value()) // This will ignore all the old Beta versions, which is what we want because they are not compatible with the launcher
-                    continue;
+            handle_error(res);
+            co_return;
+        }
 
-                for (auto const& asset : version_json.at("assets"))
-                {
-                    if (asset.at("name") != asset_name_for_current_os())
-                        continue;
-                    // This adds the version to our list of versions
-                    // We only do this is there is an actual executable ready to download
-                    version_manager().set_download_url(*version_name, asset.at("browser_download_url"));
-                    version_manager().set_changelog_url(*version_name, fmt::format("https://github.com/Coollab-Art/Coollab/blob/{}/changelog.md", std::string{version_json.at("tag_name")}));
-                    break;
-                }
-            }
-            catch (std::exception const& e)
-            {
-                Cool::Log::internal_error("Fetch list of versions", e.what());
-            }
+        auto page_releases = parse_releases(res->body, asset_name_for_current_os(), [&]() { return has_been_canceled(); });
+        if (has_been_canceled())
+            co_return;
+        if (!page_releases)
+        {
+            Cool::Log::internal_error("Fetch list of versions", page_releases.error());
+            version_manager()._status_of_fetch_list_of_versions.store(Status::Canceled); // Keep the catalog we had, rather than replacing it with an empty one
+            co_return;
         }
+
+        auto const has_reached_a_known_release = is_incremental && std::any_of(page_releases->begin(), page_releases->end(), [&](ReleaseCatalog::Release const& release) {
+                                                     return previous_catalog->contains(release.name);
+                                                 });
+        releases.insert(releases.end(), std::make_move_iterator(page_releases->begin()), std::make_move_iterator(page_releases->end()));
+        if (has_reached_a_known_release)
+            break;
+        url = next_page_url(*res);
     }
-    catch (std::exception const& e)
-    {
-        Cool::Log::internal_error("Fetch list of versions", e.what());
-    }
+    if (is_incremental)
+        releases = merge_releases(std::move(releases), previous_catalog->releases);
+    else
+        sort_releases(releases);
 
-    version_manager().on_finished_fetching_list_of_versions();
+    auto const catalog = ReleaseCatalog{
+        .releases   = std::move(releases),
+        .fetch_time = is_incremental ? previous_catalog->fetch_time : std::chrono::system_clock::now(), // Only a full fetch resets the time until the next full fetch
+    };
+    version_manager().on_finished_fetching_list_of_versions(catalog);
 
     if (_warning_notification_id.has_value())
         ImGuiNotify::close_immediately(*_warning_notification_id);
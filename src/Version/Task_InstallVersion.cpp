@@ -4,132 +4,89 @@
 #include "Cool/ImGui/markdown.h"
 #include "Cool/Task/TaskManager.hpp"
 #include "Cool/Task/TaskWithProgressBar.hpp"
+#include "Delta/download_with_delta.hpp"
+#include "Download/PartialDownload.hpp"
+#include "Download/download_file.hpp"
+#include "DownloadCache/DownloadCache.hpp"
+#include "Hash/Sha256.hpp"
 #include "ImGuiNotify/ImGuiNotify.hpp"
+#include "ObjectStore/ObjectStore.hpp"
 #include "Version.hpp"
 #include "VersionManager.hpp"
-#include "httplib.h"
+#include "VersionManifest.hpp"
+#include "Zip/download_and_extract_zip.hpp"
+#include "Zip/extract_zip.hpp"
 #include "installation_path.hpp"
-#include "make_http_request.hpp"
-#include "mz.h"
-#include "mz_strm.h"
-#include "mz_strm_mem.h"
-#include "mz_zip.h"
-#include "mz_zip_rw.h"
 #include "suggest_dl_from_github.hpp"
 #include "tl/expected.hpp"
 
-static auto download_zip(std::string const& download_url, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
-    -> tl::expected<std::string, std::string>
+#if defined(__linux__)
+/// Rebuilds the new AppImage from the blocks it shares with a version that we already have installed, and only downloads the blocks that changed
+/// Returns the SHA-256 of the AppImage, or nullopt if this was not possible, in which case we need to do a regular download
+static auto try_download_appimage_with_delta(std::optional<std::string> const& zsync_url, std::string const& download_url, std::optional<std::string> const& expected_sha256, VersionName const& version_name, std::function<void(uint64_t)> const& throttle, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> std::optional<std::string>
 {
-    auto res = make_http_request(download_url, [&](uint64_t current, uint64_t total) {
-        set_progress(static_cast<float>(current) / static_cast<float>(total));
-        return !wants_to_cancel();
-    });
-
-    if (wants_to_cancel())
-        return "";
-    if (!res)
-        return tl::make_unexpected("No Internet connection.\n\n" + suggest_dl_from_github());
-    if (res->status != 200)
-        return tl::make_unexpected("Oops, our online versions provider is unavailable, please check back later.\n\n" + suggest_dl_from_github());
-
-    return res->body;
+    if (!zsync_url.has_value())
+        return std::nullopt; // This release doesn't publish a control file
+    if (load_partial_download(download_path(version_name)).has_value())
+        return std::nullopt; // Resuming the download we had started is better
+    auto const base_version = version_manager().closest_installed_version(version_name);
+    if (!base_version.has_value())
+        return std::nullopt;
+
+    auto const success = download_with_delta(*zsync_url, download_url, executable_path(*base_version), download_path(version_name), throttle, set_progress, wants_to_cancel);
+    if (success.has_value())
+    {
+        // The file has been assembled from pieces and not received in order, so we can't hash it while downloading
+        auto sha256 = sha256_of_file(download_path(version_name));
+        if (sha256 && (!expected_sha256 || *expected_sha256 == *sha256))
+            return sha256;
+    }
+    if (!wants_to_cancel())
+        Cool::Log::internal_warning("Install version", fmt::format("Failed to upgrade from {}, falling back to a regular download: {}", base_version->as_string_pretty(), success ? "SHA-256 mismatch"s : success.error()));
+    remove_download(download_path(version_name));
+    return std::nullopt;
 }
 
-#if !defined(__linux__) // This function is not used on Linux
-static auto minizip_error_string(int32_t code) -> std::string
+/// Puts a copy of the AppImage we found in the download cache / mirror where we would have downloaded it
+static auto copy_local_appimage(std::filesystem::path const& source, std::filesystem::path const& destination) -> tl::expected<void, std::string>
 {
-    switch (code)
+    if (!Cool::File::create_folders_for_file_if_they_dont_exist(destination))
+        return tl::make_unexpected(fmt::format("Make sure you have the permission to write files in the folder \"{}\"", destination.parent_path()));
+    Cool::File::remove_file(destination);
+    auto error_code = std::error_code{};
+    std::filesystem::create_hard_link(source, destination, error_code); // The cache is on the same disk, so we don't need an actual copy. The mirror might not be though
+    if (!error_code)
+        return {};
+    error_code.clear();
+    std::filesystem::copy_file(source, destination, error_code);
+    if (error_code)
     {
-    case MZ_OK: return "Success";
-    case MZ_MEM_ERROR: return "Memory error";
-    case MZ_PARAM_ERROR: return "Invalid parameter";
-    case MZ_FORMAT_ERROR: return "ZIP format error";
-    case MZ_EXIST_ERROR: return "File already exists";
-    case MZ_OPEN_ERROR: return "Cannot open file";
-    case MZ_CLOSE_ERROR: return "Cannot close file";
-    case MZ_READ_ERROR: return "Read error";
-    case MZ_WRITE_ERROR: return "Write error";
-    case MZ_CRC_ERROR: return "CRC mismatch";
-    default: return fmt::format("Unknown error ({})", code);
+        Cool::Log::internal_warning("Install version", error_code.message());
+        return tl::make_unexpected(fmt::format("Make sure you have the permission to write files in the folder \"{}\", and that there is enough space left on your disk", destination.parent_path()));
     }
+    return {};
 }
-#endif
 
-static auto extract_zip(std::string const& zip, VersionName const& version_name, std::function<bool()> const& wants_to_cancel)
+/// On Linux we don't have a zip, just an AppImage that is already ready to use
+static auto install_appimage(std::filesystem::path const& appimage_path, VersionName const& version_name)
     -> tl::expected<void, std::string>
 {
-#if defined(__linux__)
-    // On Linux we don't have a zip, just an AppImage that is already ready to use
-    Cool::File::set_content(executable_path(version_name), zip);
-    std::ignore = wants_to_cancel;
-#else
     auto const file_error = [&]() {
         return tl::make_unexpected(fmt::format("Make sure you have the permission to write files in the folder \"{}\"", installation_path(version_name).parent_path()));
     };
-    auto const zip_error = [](std::string const& debug_error_message) {
-        Cool::Log::internal_warning("Unzip version", debug_error_message);
-        return tl::make_unexpected("An unexpected error has occurred, please try again");
-    };
-
     if (!Cool::File::create_folders_if_they_dont_exist(installation_path(version_name)))
         return file_error();
-
-    void* reader = mz_zip_reader_create();
-    if (!reader)
-        return zip_error("Failed to initialize zip reader");
-    auto const scope_guard = sg::make_scope_guard([&] { mz_zip_reader_delete(&reader); });
-
-    void* stream_mem = mz_stream_mem_create();
-    if (!stream_mem)
-        return zip_error("Failed to initialize stream memory");
-    auto const scope_guard2 = sg::make_scope_guard([&] { mz_stream_mem_delete(&stream_mem); });
-
-    mz_stream_mem_set_buffer(stream_mem, reinterpret_cast<void*>(const_cast<char*>(zip.data())), static_cast<int32_t>(zip.size())); // NOLINT(*const-cast, *reinterpret-cast)
-    {
-        auto const res = mz_stream_mem_seek(stream_mem, 0, MZ_SEEK_SET);
-        if (res != MZ_OK)
-            return zip_error(fmt::format("Failed to seek stream: {}", minizip_error_string(res)));
-    }
+    auto error_code = std::error_code{};
+    std::filesystem::rename(appimage_path, executable_path(version_name), error_code); // The download folder is inside the installation folder, so this is just a cheap move on the same disk
+    if (error_code)
     {
-        auto const res = mz_zip_reader_open(reader, stream_mem);
-        if (res != MZ_OK)
-            return zip_error(fmt::format("Failed to open zip from memory: {}", minizip_error_string(res)));
-    }
-    auto const scope_guard3 = sg::make_scope_guard([&] { mz_zip_reader_close(reader); });
-
-    while (mz_zip_reader_goto_next_entry(reader) == MZ_OK)
-    {
-        if (wants_to_cancel())
-            return {}; // No error
-
-        {
-            auto const res = mz_zip_reader_entry_open(reader);
-            if (res != MZ_OK)
-                return zip_error(fmt::format("Failed to open zip entry: {}", minizip_error_string(res)));
-        }
-        auto const scope_guard4 = sg::make_scope_guard([&] { mz_zip_reader_entry_close(reader); });
-
-        mz_zip_file* file_info{};
-        {
-            auto const res = mz_zip_reader_entry_get_info(reader, &file_info);
-            if (res != MZ_OK || file_info == nullptr || file_info->filename == nullptr)
-                return zip_error(fmt::format("Failed to get entry info: {}", minizip_error_string(res)));
-        }
-
-        auto const full_path = installation_path(version_name) / file_info->filename;
-        if (!Cool::File::create_folders_for_file_if_they_dont_exist(full_path))
-            return file_error();
-
-        {
-            auto const res = mz_zip_reader_entry_save_file(reader, full_path.string().c_str());
-            if (res != MZ_OK)
-                return zip_error(fmt::format("Failed to extract file \"{}\": {}", file_info->filename, minizip_error_string(res)));
-        }
+        Cool::Log::internal_warning("Install version", error_code.message());
+        return file_error();
     }
-#endif
     return {};
 }
+#endif
 
 static auto make_file_executable(std::filesystem::path const& path) -> tl::expected<void, std::string>
 {
@@ -171,7 +128,7 @@ void Task_InstallVersion::on_submit()
 
 auto Task_InstallVersion::notification_when_submitted() const -> ImGuiNotify::Notification
 {
-    if (version_manager().status_of_fetch_list_of_versions() == Status::Completed)
+    if (version_manager().has_list_of_versions())
         return Cool::TaskWithProgressBar::notification_when_submitted();
 
     return ImGuiNotify::Notification{
@@ -220,6 +177,8 @@ auto Task_InstallVersion::extra_imgui_below_progress_bar() const -> std::functio
 void Task_InstallVersion::cleanup_impl(bool has_been_canceled)
 {
     Cool::TaskWithProgressBar::cleanup_impl(has_been_canceled);
+    install_scheduler().finish(*_install_ticket); // Let the next install start
+    auto const scope_guard = sg::make_scope_guard([&] { _completion.complete(!has_been_canceled && !_error_message.has_value()); }); // Last, so that the tasks waiting for us see the version as installed
 
     if (!_version_name.has_value())
         return;
@@ -228,20 +187,33 @@ void Task_InstallVersion::cleanup_impl(bool has_been_canceled)
     {
         version_manager().set_installation_status(*_version_name, InstallationStatus::NotInstalled);
         Cool::File::remove_folder(installation_path(*_version_name)); // Cleanup any files that we might have started to extract from the zip
+        // In case we had started to add the files of this version to the store
+        ObjectStore::release(*_version_name);
+        remove_version_manifest(*_version_name);
+        remove_download_unless_it_can_be_resumed(download_path(*_version_name)); // Keep what we have downloaded so far, so that the next attempt doesn't have to start from scratch
     }
     else
     {
         version_manager().set_installation_status(*_version_name, InstallationStatus::Installed);
+        remove_download(download_path(*_version_name)); // On Linux it has already been moved to its installation path, but on other platforms it was a zip that we don't need anymore after extracting it (the download cache keeps its own link to it)
     }
 }
 
+auto Task_InstallVersion::download_options() const -> DownloadOptions
+{
+    return DownloadOptions{
+        .expected_sha256 = _sha256,
+        .throttle        = [ticket = _install_ticket](uint64_t nb_bytes) { install_scheduler().throttle(*ticket, nb_bytes); },
+    };
+}
+
 auto Task_InstallVersion::execute() -> Cool::TaskCoroutine
 {
     // Find version name and/or download url if necessary
     // We need to do this in execute, because we might have been waiting for FetchListOfVersions to finish, so we didn't have access to the download url before that point
     if (!_version_name.has_value()) // If we don't give us a version name, we will install the latest version (this happens when we want to install the latest version, but haven't fetched the list of versions yet so we can't know its name when creating the install task)
     {
-        auto const* const version = version_manager().latest_version(false /*filter_experimental_versions*/);
+        auto const version = version_manager().latest_version(false /*filter_experimental_versions*/);
         if (!version || !version->download_url.has_value())
         {
             _error_message = "Didn't find any version to install";
@@ -250,11 +222,13 @@ auto Task_InstallVersion::execute() -> Cool::TaskCoroutine
         _version_name  = version->name;
         _download_url  = version->download_url;
         _changelog_url = version->changelog_url;
+        _zsync_url     = version->zsync_url;
+        _sha256        = version->sha256;
         version_manager().set_installation_status(*_version_name, InstallationStatus::Installing);
     }
     if (!_download_url.has_value())
     {
-        auto const* const version = version_manager().find(*_version_name, false /*filter_experimental_versions*/);
+        auto const version = version_manager().find(*_version_name, false /*filter_experimental_versions*/);
         if (!version || !version->download_url.has_value())
         {
             _error_message = "This version is not available online";
@@ -262,21 +236,70 @@ auto Task_InstallVersion::execute() -> Cool::TaskCoroutine
         }
         _download_url  = version->download_url;
         _changelog_url = version->changelog_url;
+        _zsync_url     = version->zsync_url;
+        _sha256        = version->sha256;
     }
     change_notification(notification_while_in_progress()); // Must be done after finding the _changelog_url, because this will call extra_imgui_below_progress_bar(), which needs _changelog_url
 
-    // Download zip
-    auto const zip = download_zip(*_download_url, [&](float progress) { set_progress(progress * 0.99f); }, [&]() { return has_been_canceled(); });
-    if (has_been_canceled())
-        co_return;
-    if (!zip.has_value())
+    auto manifest = VersionManifest{.asset_is_verified = _sha256.has_value()}; // If we have a checksum, the download fails when it doesn't match
+
+    // Before using the network, check if we already have this asset (because we installed this version before, or because it is in the mirror folder)
+    auto const local_asset = DownloadCache::find(*_download_url, _sha256, _download_mirror_folder);
+
+#if defined(__linux__)
+    if (local_asset.has_value())
+    {
+        auto const success = copy_local_appimage(local_asset->path, download_path(*_version_name));
+        if (!success.has_value())
+        {
+            _error_message = success.error();
+            co_return;
+        }
+        manifest.asset_sha256 = local_asset->sha256;
+    }
+    else if (auto sha256 = try_download_appimage_with_delta(_zsync_url, *_download_url, _sha256, *_version_name, download_options().throttle, [&](float progress) { set_progress(progress * 0.99f); }, [&]() { return has_been_canceled(); }))
     {
-        _error_message = zip.error();
-        co_return;
+        manifest.asset_sha256 = std::move(*sha256);
+    }
+    else
+    { // Download AppImage
+        if (has_been_canceled())
+            co_return;
+        auto success = download_file(*_download_url, download_path(*_version_name), download_options(), [&](float progress) { set_progress(progress * 0.99f); }, [&]() { return has_been_canceled(); });
+        if (has_been_canceled())
+            co_return;
+        if (!success.has_value())
+        {
+            _error_message = success.error();
+            co_return;
+        }
+        manifest.asset_sha256 = std::move(*success);
     }
 
-    { // Extract zip
-        auto const success = extract_zip(*zip, *_version_name, [&]() { return has_been_canceled(); });
+    { // Install AppImage
+        auto const success = install_appimage(download_path(*_version_name), *_version_name);
+        if (!success.has_value())
+        {
+            _error_message = success.error();
+            co_return;
+        }
+    }
+#else
+    if (local_asset.has_value())
+    {
+        auto const success = extract_zip(local_asset->path, installation_path(*_version_name), [&](float progress) { set_progress(progress * 0.99f); }, [&]() { return has_been_canceled(); });
+        if (has_been_canceled())
+            co_return;
+        if (!success.has_value())
+        {
+            _error_message = success.error();
+            co_return;
+        }
+        manifest.asset_sha256 = local_asset->sha256;
+    }
+    else
+    { // Download and extract zip. The extraction starts while the zip is still downloading
+        auto success = download_and_extract_zip(*_download_url, download_path(*_version_name), installation_path(*_version_name), download_options(), [&](float progress) { set_progress(progress * 0.99f); }, [&]() { return has_been_canceled(); });
         if (has_been_canceled())
             co_return;
         if (!success.has_value())
@@ -284,7 +307,9 @@ auto Task_InstallVersion::execute() -> Cool::TaskCoroutine
             _error_message = success.error();
             co_return;
         }
+        manifest.asset_sha256 = std::move(*success);
     }
+#endif
 
     { // Make file executable
         auto const success = make_file_executable(executable_path(*_version_name));
@@ -294,4 +319,18 @@ auto Task_InstallVersion::execute() -> Cool::TaskCoroutine
             co_return;
         }
     }
+
+#if defined(__linux__)
+    manifest.set_sha256(installation_path(*_version_name), executable_path(*_version_name), manifest.asset_sha256); // The AppImage is the file we downloaded, so we already know its hash
+    auto const downloaded_asset = executable_path(*_version_name);
+#else
+    auto const downloaded_asset = download_path(*_version_name);
+#endif
+    if (!local_asset.has_value()) // Keep it, so that reinstalling this version later doesn't need the network
+        DownloadCache::add(*_download_url, downloaded_asset, manifest.asset_sha256, _download_cache_max_size);
+
+    // Must be done after making the file executable, because the permissions are part of what identifies a file in the store
+    ObjectStore::deduplicate(*_version_name, manifest, [&]() { return has_been_canceled(); });
+    if (!has_been_canceled())
+        save_version_manifest(*_version_name, manifest);
 }
@@ -1,16 +1,28 @@
 #pragma once
+#include "CompletionSignal/CompletionSignal.hpp"
 #include "Cool/Task/TaskWithProgressBar.hpp"
+#include "Download/download_file.hpp"
 #include "ImGuiNotify/ImGuiNotify.hpp"
+#include "InstallScheduler.hpp"
+#include "LauncherSettings.hpp"
 #include "VersionName.hpp"
 
 class Task_InstallVersion : public Cool::TaskWithProgressBar {
 public:
     /// Will install the latest version if we pass nullopt
-    explicit Task_InstallVersion(std::optional<VersionName> version_name = {})
+    explicit Task_InstallVersion(std::optional<VersionName> version_name = {}, InstallPriority priority = InstallPriority::UserInitiated)
         : Cool::TaskWithProgressBar{fmt::format("Installing {}", version_name ? version_name->as_string_pretty() : "latest version")}
         , _version_name{std::move(version_name)}
+        , _install_ticket{install_scheduler().make_ticket(priority)}
+        , _download_mirror_folder{launcher_settings().download_mirror_folder()}
+        , _download_cache_max_size{launcher_settings().download_cache_max_size_in_bytes()}
     {}
 
+    /// The task must not start executing before the scheduler allows it
+    auto install_ticket() const -> std::shared_ptr<InstallScheduler::Ticket> const& { return _install_ticket; }
+    /// `callback` is called as soon as the task completes, with true iff the version has been installed
+    void then(std::function<void(bool has_been_installed)> callback) { _completion.then(std::move(callback)); }
+
 private:
     void on_submit() override;
     auto execute() -> Cool::TaskCoroutine override;
@@ -21,10 +33,22 @@ private:
     auto notification_after_execution_completes() const -> ImGuiNotify::Notification override;
     auto extra_imgui_below_progress_bar() const -> std::function<void(ImGuiNotify::NotificationId const&)> override;
 
+    auto download_options() const -> DownloadOptions;
+
 private:
     std::optional<VersionName> _version_name{};
     std::optional<std::string> _download_url{};
     std::optional<std::string> _changelog_url{};
+    std::optional<std::string> _zsync_url{};
+    std::optional<std::string> _sha256{};
+
+    std::shared_ptr<InstallScheduler::Ticket> _install_ticket;
+
+    // Copied when the task is created, so that the settings can change while we install
+    std::filesystem::path _download_mirror_folder;
+    uint64_t              _download_cache_max_size;
 
     std::optional<std::string> _error_message{};
+
+    CompletionSignal _completion{};
 };
@@ -29,19 +29,48 @@ Task_LaunchVersion::Task_LaunchVersion(VersionRef version_ref, ProjectToOpenOrCr
     , _project_to_open_or_create{std::move(project_to_open_or_create)}
 {}
 
-void Task_LaunchVersion::on_submit()
+void Task_LaunchVersion::notify_waiting_for_install()
 {
-    _notification_id = ImGuiNotify::send({
+    _is_waiting_for_install = true;
+    _notification_id        = ImGuiNotify::send({
         .type                 = ImGuiNotify::Type::Info,
         .title                = name(),
         .content              = fmt::format("Waiting for {} to install", as_string_pretty(_version_ref)),
+        .custom_imgui_content = [canceled = _canceled_while_waiting](ImGuiNotify::NotificationId const& notification_id) {
+            if (ImGui::Button("Cancel"))
+            {
+                canceled->store(true); // The task isn't submitted yet, so we can't cancel it through the task manager
+                ImGuiNotify::close_immediately(notification_id);
+            }
+        },
+        .duration = std::nullopt,
+        .closable = false,
+    });
+}
+
+void Task_LaunchVersion::stop_waiting_for_install()
+{
+    if (_is_waiting_for_install)
+        ImGuiNotify::close_immediately(_notification_id);
+}
+
+void Task_LaunchVersion::on_submit()
+{
+    auto notification = ImGuiNotify::Notification{
+        .type                 = ImGuiNotify::Type::Info,
+        .title                = name(),
+        .content              = fmt::format("Starting {}", as_string_pretty(_version_ref)), // We are only submitted once the version is installed
         .custom_imgui_content = [task_id = owner_id()](ImGuiNotify::NotificationId const&) {
             if (ImGui::Button("Cancel"))
                 Cool::task_manager().cancel_all(task_id);
         },
         .duration = std::nullopt,
         .closable = false,
-    });
+    };
+    if (_is_waiting_for_install)
+        ImGuiNotify::change(_notification_id, std::move(notification));
+    else
+        _notification_id = ImGuiNotify::send(std::move(notification));
 }
 
 void Task_LaunchVersion::cleanup_impl(bool /* has_been_canceled */)
@@ -66,7 +95,7 @@ void Task_LaunchVersion::cleanup_impl(bool /* has_been_canceled */)
 
 auto Task_LaunchVersion::execute() -> Cool::TaskCoroutine
 {
-    auto const* const version = version_manager().find_installed_version(_version_ref, false /*filter_experimental_versions*/);
+    auto const version = version_manager().find_installed_version(_version_ref, false /*filter_experimental_versions*/);
     if (!version || version->installation_status != InstallationStatus::Installed)
     {
         _error_message = fmt::format("Can't launch because we failed to install {}", as_string_pretty(_version_ref));
@@ -10,6 +10,13 @@ class Task_LaunchVersion : public Cool::Task {
 public:
     explicit Task_LaunchVersion(VersionRef version_ref, ProjectToOpenOrCreate project_to_open_or_create);
 
+    /// Lets the user know (and cancel) the launch while the version is installing, before the task gets submitted
+    void notify_waiting_for_install();
+    /// Once it returns true, the task must not be submitted anymore
+    auto has_been_canceled_while_waiting() const -> bool { return _canceled_while_waiting->load(); }
+    /// Must be called if the task will never be submitted (e.g. the install failed), to close the notification
+    void stop_waiting_for_install();
+
 private:
     void on_submit() override;
     auto execute() -> Cool::TaskCoroutine override;
@@ -18,8 +25,10 @@ private:
     auto needs_user_confirmation_to_cancel_when_closing_app() const -> bool override { return false; }
 
 private:
-    VersionRef                  _version_ref;
-    ProjectToOpenOrCreate       _project_to_open_or_create{};
-    ImGuiNotify::NotificationId _notification_id{};
-    std::string                 _error_message{""};
+    VersionRef                         _version_ref;
+    ProjectToOpenOrCreate              _project_to_open_or_create{};
+    ImGuiNotify::NotificationId        _notification_id{};
+    bool                               _is_waiting_for_install{false};
+    std::shared_ptr<std::atomic<bool>> _canceled_while_waiting{std::make_shared<std::atomic<bool>>(false)}; // Shared with the Cancel button of the notification, which can outlive the task
+    std::string                        _error_message{""};
 };
\ No newline at end of file
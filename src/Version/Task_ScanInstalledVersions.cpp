@@ -0,0 +1,12 @@
+#include "Task_ScanInstalledVersions.hpp"
+#include "InstalledVersions.hpp"
+#include "VersionManager.hpp"
+
+auto Task_ScanInstalledVersions::execute() -> Cool::TaskCoroutine
+{
+    auto const statuses_before_scan = version_manager().installation_statuses();
+    auto const installed_versions   = scan_installed_versions();
+    if (has_been_canceled())
+        co_return;
+    version_manager().on_finished_scanning_installed_versions(installed_versions, statuses_before_scan);
+}
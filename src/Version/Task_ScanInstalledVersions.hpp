@@ -0,0 +1,14 @@
+#pragma once
+#include "Cool/Task/Task.hpp"
+
+/// Scans the installation folder, to notice the versions that have been added or removed without the launcher knowing about it (e.g. the user deleted a folder manually)
+class Task_ScanInstalledVersions : public Cool::Task {
+public:
+    Task_ScanInstalledVersions()
+        : Cool::Task{"Scanning the installed versions"}
+    {}
+
+private:
+    auto execute() -> Cool::TaskCoroutine override;
+    auto needs_user_confirmation_to_cancel_when_closing_app() const -> bool override { return false; }
+};
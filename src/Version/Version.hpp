@@ -12,6 +12,8 @@ struct Version {
     InstallationStatus         installation_status{};
     std::optional<std::string> download_url{};
     std::optional<std::string> changelog_url{};
+    std::optional<std::string> sha256{};    // Checksum of the asset we download, when the release publishes it
+    std::optional<std::string> zsync_url{}; // Describes the blocks of the AppImage, so that we can only download the parts that changed since a version we already have
 
     friend auto operator<=>(Version const& a, Version const& b) { return b.name <=> a.name; } // Compare b to a and not the other way around because when sorting or vector of Version, we want the latest to be at the front
     friend auto operator==(Version const& a, Version const& b) -> bool { return a.name == b.name; }
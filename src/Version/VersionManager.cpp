@@ -13,141 +13,286 @@
 #include "Cool/Task/TaskManager.hpp"
 #include "Cool/Task/WaitToExecuteTask.hpp"
 #include "Cool/Utils/overloaded.hpp"
+#include "InstalledVersions.hpp"
 #include "LauncherSettings.hpp"
+#include "ObjectStore/ObjectStore.hpp"
 #include "Path.hpp"
 #include "Status.hpp"
 #include "Task_FetchListOfVersions.hpp"
 #include "Task_InstallVersion.hpp"
 #include "Task_LaunchVersion.hpp"
+#include "Task_ScanInstalledVersions.hpp"
 #include "Version.hpp"
 #include "Version/installation_path.hpp"
+#include "VersionManifest.hpp"
 #include "VersionName.hpp"
 #include "VersionRef.hpp"
 #include "fmt/format.h"
 #include "installation_path.hpp"
+#include "range/v3/view.hpp"
 
-static auto get_all_locally_installed_versions() -> std::vector<Version>
+/// Uses the list we saved, so that we don't have to scan the installation folder on the startup path. If it might be outdated, a scan will be done in the background
+static auto get_all_locally_installed_versions(bool& needs_to_scan) -> std::vector<Version>
 {
+    auto installed_versions = load_installed_versions();
+    if (!installed_versions.has_value()) // First time we launch, or the list has been deleted: we have no other choice than to scan now
+    {
+        installed_versions = InstalledVersions{.versions = scan_installed_versions()};
+        save_installed_versions(installed_versions->versions);
+    }
+    needs_to_scan = installed_versions->might_be_outdated;
+
     auto versions = std::vector<Version>{};
-    try
+    for (auto& name : installed_versions->versions)
+        versions.push_back(Version{std::move(name), InstallationStatus::Installed});
+    std::sort(versions.begin(), versions.end());
+    return versions;
+}
+
+static auto installed_version_names(std::vector<Version> const& versions) -> std::vector<VersionName>
+{
+    auto names = std::vector<VersionName>{};
+    for (auto const& version : versions)
     {
-        for (auto const& entry : std::filesystem::directory_iterator{Path::installed_versions_folder()})
+        if (version.installation_status == InstallationStatus::Installed)
+            names.push_back(version.name);
+    }
+    return names;
+}
+
+/// Whether the experimental versions must be filtered out. Computed once and not for each version, because it reads the settings
+static auto hides_experimental_versions(bool filter_experimental_versions) -> bool
+{
+    return filter_experimental_versions && !launcher_settings().show_experimental_versions;
+}
+
+static auto filtered(std::vector<Version> const& versions, bool filter_experimental_versions)
+{
+    return versions | ranges::views::filter([hide_experimental_versions = hides_experimental_versions(filter_experimental_versions)](Version const& version) { return !hide_experimental_versions || !version.name.is_experimental(); });
+}
+
+void VersionManager::State::update_cache()
+{
+    latest = {};
+    for (size_t i = versions.size(); i-- > 0;) // From oldest to latest, so that the latest one overwrites the others
+    {
+        auto const& version = versions[i];
+        for (size_t filter = 0; filter < 2; ++filter)
         {
-            try
-            {
-                if (!entry.is_directory())
-                    continue;
-                auto const name = entry.path().filename().string(); // Use filename() and not stem(), because stem() would stop at the first dot (e.g. "folder/19.0.3" would become "19" instead of "19.0.3")
-                if (std::none_of(versions.begin(), versions.end(), [&](Version const& version) {
-                        return version.name.as_string_raw() == name;
-                    }))
-                {
-                    auto const version_name = VersionName::from(name);
-                    if (version_name.has_value())
-                        versions.emplace_back(Version{*version_name, InstallationStatus::Installed});
-                }
-            }
-            catch (std::exception const& e)
-            {
-                Cool::Log::internal_error("Get all locally installed versions", e.what());
-            }
+            if (filter == 1 && version.name.is_experimental())
+                continue;
+            latest[filter].version = i;
+            if (version.installation_status == InstallationStatus::Installed)
+                latest[filter].installed_version = i;
+            if (version.download_url.has_value())
+                latest[filter].version_with_download_url = i;
         }
     }
-    catch (std::exception const& e)
+}
+
+auto VersionManager::State::get(std::optional<size_t> index) const -> Version const*
+{
+    return index.has_value() ? &versions[*index] : nullptr;
+}
+
+auto VersionManager::State::find(VersionName const& name, bool filter_experimental_versions) const -> Version const*
+{
+    if (name.is_experimental() && hides_experimental_versions(filter_experimental_versions))
+        return nullptr;
+
+    // Versions are sorted, so we can use a binary search. But several names can have the same position in the order (e.g. "1.0.0" and "1.0.0 MacOS"), so we still need to compare the names
+    auto const [begin, end] = std::equal_range(versions.begin(), versions.end(), Version{name});
+    auto const it           = std::find_if(begin, end, [&](Version const& version) {
+        return version.name == name;
+    });
+    if (it == end)
+        return nullptr;
+    return &*it;
+}
+
+auto VersionManager::State::latest_version(bool filter_experimental_versions) const -> Version const*
+{
+    return get(latest[hides_experimental_versions(filter_experimental_versions) ? 1 : 0].version);
+}
+
+auto VersionManager::State::latest_installed_version(bool filter_experimental_versions) const -> Version const*
+{
+    return get(latest[hides_experimental_versions(filter_experimental_versions) ? 1 : 0].installed_version);
+}
+
+auto VersionManager::State::latest_version_with_download_url(bool filter_experimental_versions) const -> Version const*
+{
+    return get(latest[hides_experimental_versions(filter_experimental_versions) ? 1 : 0].version_with_download_url);
+}
+
+/// Both lists are sorted from latest to oldest, so we can merge them in one pass instead of looking each release up in the versions
+static void merge_release_catalog(std::vector<Version>& versions, ReleaseCatalog const& catalog)
+{
+    auto       merged  = std::vector<Version>{};
+    auto       version = versions.begin();
+    auto       release = catalog.releases.begin();
+    auto const add     = [&](Version new_version, ReleaseCatalog::Release const* online_release) {
+        // Forget what the previous catalog told us, in case this release has been removed since
+        new_version.download_url  = online_release ? std::make_optional(online_release->download_url) : std::nullopt;
+        new_version.changelog_url = online_release ? std::make_optional(online_release->changelog_url) : std::nullopt;
+        new_version.zsync_url     = online_release ? online_release->zsync_url : std::nullopt;
+        new_version.sha256        = online_release ? online_release->sha256 : std::nullopt;
+        if (new_version.installation_status != InstallationStatus::NotInstalled || new_version.download_url.has_value()) // Otherwise it is neither installed nor available online anymore
+            merged.push_back(std::move(new_version));
+    };
+    merged.reserve(versions.size() + catalog.releases.size());
+    while (version != versions.end() || release != catalog.releases.end())
     {
-        Cool::Log::internal_error("Get all locally installed versions", e.what());
+        if (release == catalog.releases.end() || (version != versions.end() && release->name < version->name))
+        {
+            add(std::move(*version), nullptr);
+            ++version;
+        }
+        else if (version == versions.end() || version->name < release->name)
+        {
+            add(Version{release->name, InstallationStatus::NotInstalled}, &*release); // This adds the version to our list of versions
+            ++release;
+        }
+        else
+        {
+            add(std::move(*version), &*release);
+            ++version;
+            ++release;
+        }
     }
-    std::sort(versions.begin(), versions.end());
-    return versions;
+    versions = std::move(merged);
 }
 
-// TODO(Launcher) Make VersionManager thread safe
+static auto initial_versions(bool& has_release_catalog, bool& needs_to_scan_installed_versions) -> std::vector<Version>
+{
+    auto versions = get_all_locally_installed_versions(needs_to_scan_installed_versions);
+    // Use the list of versions we fetched last time, so that we don't have to wait for the network. Fetching the list will then refresh it in the background
+    if (auto const catalog = load_release_catalog())
+    {
+        merge_release_catalog(versions, *catalog);
+        has_release_catalog = true;
+    }
+    return versions;
+}
 
 VersionManager::VersionManager()
-    : _versions{get_all_locally_installed_versions()}
 {
+    auto needs_to_scan_installed_versions = false;
+    modify_versions([&](std::vector<Version>& versions) {
+        versions = initial_versions(_has_release_catalog, needs_to_scan_installed_versions);
+    });
+    if (needs_to_scan_installed_versions)
+        Cool::task_manager().submit(std::make_shared<Task_ScanInstalledVersions>());
     // TODO(Launcher) make sure to not send a request if we know which project to launch, and we already have that version, to save on the number of requests allowed by Github
     Cool::task_manager().submit(std::make_shared<Task_FetchListOfVersions>());
 }
 
-class WaitToExecuteTask_HasFetchedListOfVersions : public Cool::WaitToExecuteTask {
+VersionManager::VersionManager(std::vector<Version> versions)
+{
+    modify_versions([&](std::vector<Version>& current_versions) {
+        current_versions = std::move(versions);
+    });
+}
+
+/// Waits until we know the list of versions (to know the download url), and the install scheduler lets us start
+class WaitToExecuteTask_CanStartInstall : public Cool::WaitToExecuteTask {
 public:
-    auto wants_to_execute() -> bool override { return version_manager().status_of_fetch_list_of_versions() == Status::Completed; }
-    auto wants_to_cancel() -> bool override { return version_manager().status_of_fetch_list_of_versions() == Status::Canceled; }
+    explicit WaitToExecuteTask_CanStartInstall(std::weak_ptr<InstallScheduler::Ticket> ticket)
+        : _ticket{std::move(ticket)}
+    {}
+
+    auto wants_to_execute() -> bool override
+    {
+        if (!version_manager().has_list_of_versions())
+            return false;
+        auto const ticket = _ticket.lock();
+        return !ticket || install_scheduler().try_start(*ticket); // Must be checked last, because it takes a slot
+    }
+    auto wants_to_cancel() -> bool override { return !version_manager().has_list_of_versions() && version_manager().status_of_fetch_list_of_versions() == Status::Canceled; }
+
+private:
+    std::weak_ptr<InstallScheduler::Ticket> _ticket; // Weak, so that we don't keep the ticket alive after the install task has been destroyed
 };
 
-static auto after_has_fetched_list_of_versions() -> std::shared_ptr<Cool::WaitToExecuteTask>
+void VersionManager::submit_install_task(std::shared_ptr<Task_InstallVersion> const& install_task)
 {
-    return std::make_shared<WaitToExecuteTask_HasFetchedListOfVersions>();
+    Cool::task_manager().submit(std::make_shared<WaitToExecuteTask_CanStartInstall>(install_task->install_ticket()), install_task);
 }
 
-auto VersionManager::after_version_installed(VersionRef const& version_ref) -> std::shared_ptr<Cool::WaitToExecuteTask>
+auto VersionManager::install_task_to_wait_for(VersionRef const& version_ref) -> std::shared_ptr<Task_InstallVersion>
 {
-    auto const after_latest_version_installed = [&]() {
-        if (_status_of_fetch_list_of_versions.load() == Status::Completed)
+    auto const latest_version_install_task = [&]() {
+        if (has_list_of_versions())
         {
-            auto const* const latest_version = latest_version_with_download_url_no_locking(true /*filter_experimental_versions*/);
+            auto const        state          = _state.snapshot();
+            auto const* const latest_version = state->latest_version_with_download_url(true /*filter_experimental_versions*/);
             if (!latest_version)
             {
                 // TODO(Launcher) error, should not happen
             }
-            auto const install_task = get_install_task_or_create_and_submit_it(latest_version->name);
-            return after(install_task);
+            return get_install_task_or_create_and_submit_it(latest_version->name, InstallPriority::UserInitiated); // We want to launch it
         }
         else if (has_at_least_one_version_installed(true /*filter_experimental_versions*/))
         {
             // We don't want to wait, use whatever version is available
-            return after_nothing();
+            return std::shared_ptr<Task_InstallVersion>{};
         }
         else
         {
             auto const task_install_latest_version = std::make_shared<Task_InstallVersion>(); // TODO(Launcher) When this task starts executing, it should register itself as an installing task to the version manager. Because since we don't yet know which version it will install we can't put it in the _install_tasks list immediately
-            Cool::task_manager().submit(after_has_fetched_list_of_versions(), task_install_latest_version);
-            return after(task_install_latest_version);
+            submit_install_task(task_install_latest_version);
+            return task_install_latest_version;
         }
     };
-    // TODO(Launcher) lock
     return std::visit(
         Cool::overloaded{
-            [&](LatestVersion) -> std::shared_ptr<Cool::WaitToExecuteTask> {
-                return after_latest_version_installed();
+            [&](LatestVersion) -> std::shared_ptr<Task_InstallVersion> {
+                return latest_version_install_task();
             },
-            [&](LatestInstalledVersion) -> std::shared_ptr<Cool::WaitToExecuteTask> {
+            [&](LatestInstalledVersion) -> std::shared_ptr<Task_InstallVersion> {
                 if (has_at_least_one_version_installed(true /*filter_experimental_versions*/))
-                    return after_nothing();
+                    return nullptr;
 
                 auto const install_task = get_latest_installing_version_if_any();
                 if (install_task)
-                    return after(install_task);
+                    return install_task;
                 else // NOLINT(*else-after-return)
-                    return after_latest_version_installed();
+                    return latest_version_install_task();
             },
-            [&](VersionName const& version_name) -> std::shared_ptr<Cool::WaitToExecuteTask> {
+            [&](VersionName const& version_name) -> std::shared_ptr<Task_InstallVersion> {
                 if (is_installed(version_name, false /*filter_experimental_versions*/))
-                    return after_nothing();
-                auto const install_task = get_install_task_or_create_and_submit_it(version_name);
-                return after(install_task);
+                    return nullptr;
+                return get_install_task_or_create_and_submit_it(version_name, InstallPriority::UserInitiated); // We want to launch it
             }
         },
         version_ref
     );
 }
 
-auto VersionManager::get_install_task_or_create_and_submit_it(VersionName const& version_name) -> std::shared_ptr<Cool::Task>
+auto VersionManager::get_install_task_or_create_and_submit_it(VersionName const& version_name, InstallPriority priority) -> std::shared_ptr<Task_InstallVersion>
 {
-    auto const it = _install_tasks.find(version_name);
-    if (it != _install_tasks.end())
-        return it->second;
+    auto install_task = std::shared_ptr<Task_InstallVersion>{};
+    {
+        auto       lock = std::unique_lock{_install_tasks_mutex};
+        auto const it   = _install_tasks.find(version_name);
+        if (it != _install_tasks.end())
+        {
+            it->second->install_ticket()->raise_priority_to(priority); // e.g. it was installing in the background, and now the user is waiting for it
+            return it->second;
+        }
 
-    auto const install_task = std::make_shared<Task_InstallVersion>(version_name);
-    Cool::task_manager().submit(after_has_fetched_list_of_versions(), install_task);
-    _install_tasks.insert(std::make_pair(version_name, install_task));
+        install_task = std::make_shared<Task_InstallVersion>(version_name, priority);
+        _install_tasks.insert(std::make_pair(version_name, install_task));
+    }
+    submit_install_task(install_task); // Outside of the lock, because submitting the task calls set_installation_status()
     return install_task;
 }
 
-auto VersionManager::get_latest_installing_version_if_any() const -> std::shared_ptr<Cool::Task>
+auto VersionManager::get_latest_installing_version_if_any() const -> std::shared_ptr<Task_InstallVersion>
 {
-    auto res      = std::shared_ptr<Cool::Task>{};
+    auto lock = std::unique_lock{_install_tasks_mutex};
+
+    auto res      = std::shared_ptr<Task_InstallVersion>{};
     auto ver_name = std::optional<VersionName>{};
     for (auto const& [version_name, task] : _install_tasks)
     {
@@ -164,220 +309,214 @@ auto VersionManager::get_latest_installing_version_if_any() const -> std::shared
 
 void VersionManager::install_ifn_and_launch(VersionRef const& version_ref, ProjectToOpenOrCreate project_to_open_or_create)
 {
-    Cool::task_manager().submit(
-        after_version_installed(version_ref),
-        std::make_shared<Task_LaunchVersion>(version_ref, std::move(project_to_open_or_create))
-    );
+    auto const launch_task  = std::make_shared<Task_LaunchVersion>(version_ref, std::move(project_to_open_or_create));
+    auto const install_task = install_task_to_wait_for(version_ref);
+    if (!install_task)
+    {
+        Cool::task_manager().submit(launch_task);
+        return;
+    }
+    // Submitted by the install task as soon as it completes, so that we don't wait for the task manager to poll a WaitToExecuteTask before launching
+    launch_task->notify_waiting_for_install();
+    install_task->then([launch_task](bool has_been_installed) {
+        if (launch_task->has_been_canceled_while_waiting())
+            return;
+        if (has_been_installed)
+            Cool::task_manager().submit(launch_task);
+        else
+            launch_task->stop_waiting_for_install(); // The install task has already told the user why it failed (or they canceled it themselves)
+    });
 }
 
 void VersionManager::install_latest_version(bool filter_experimental_versions)
 {
-    auto const* const latest_version = latest_version_no_locking(filter_experimental_versions);
+    auto const latest_version = this->latest_version(filter_experimental_versions);
     if (latest_version && latest_version->installation_status == InstallationStatus::NotInstalled)
-        install(*latest_version);
+        install(*latest_version, InstallPriority::Background);
 }
 
-void VersionManager::install(Version const& version)
+void VersionManager::install(Version const& version, InstallPriority priority)
 {
     if (version.installation_status != InstallationStatus::NotInstalled)
     {
         assert(false);
         return;
     }
-    get_install_task_or_create_and_submit_it(version.name);
+    get_install_task_or_create_and_submit_it(version.name, priority);
 }
 
-void VersionManager::uninstall(Version& version)
+void VersionManager::uninstall(VersionName const& name)
 {
-    if (version.installation_status != InstallationStatus::Installed)
+    if (!is_installed(name, false /*filter_experimental_versions*/))
     {
         assert(false);
         return;
     }
-    Cool::File::remove_folder(installation_path(version.name));
-    version.installation_status = InstallationStatus::NotInstalled;
-}
-
-auto VersionManager::find(VersionName const& name, bool filter_experimental_versions) const -> Version const*
-{
-    // auto lock = std::unique_lock{_mutex};
-    return find_no_locking(name, filter_experimental_versions);
+    Cool::File::remove_folder(installation_path(name));
+    ObjectStore::release(name); // Must be done after removing the folder, so that the files that were only used by this version are not referenced anymore
+    remove_version_manifest(name);
+    set_installation_status(name, InstallationStatus::NotInstalled);
 }
 
-auto VersionManager::find_no_locking(VersionName const& name, bool filter_experimental_versions) -> Version*
+auto VersionManager::find(VersionName const& name, bool filter_experimental_versions) const -> std::shared_ptr<Version const>
 {
-    auto filtered_versions = versions(filter_experimental_versions);
-
-    auto const it = std::find_if(filtered_versions.begin(), filtered_versions.end(), [&](Version const& version) {
-        return version.name == name;
-    });
-    if (it == filtered_versions.end())
-        return nullptr;
-    return &*it;
+    auto const        state   = _state.snapshot();
+    auto const* const version = state->find(name, filter_experimental_versions);
+    return std::shared_ptr<Version const>{state, version}; // The version keeps the whole snapshot alive
 }
 
-auto VersionManager::find_no_locking(VersionName const& name, bool filter_experimental_versions) const -> Version const*
+auto VersionManager::find_installed_version(VersionRef const& version_ref, bool filter_experimental_versions) const -> std::shared_ptr<Version const>
 {
-    auto filtered_versions = versions(filter_experimental_versions);
-
-    auto const it = std::find_if(filtered_versions.begin(), filtered_versions.end(), [&](Version const& version) {
-        return version.name == name;
-    });
-    if (it == filtered_versions.end())
-        return nullptr;
-    return &*it;
-}
-
-auto VersionManager::find_installed_version(VersionRef const& version_ref, bool filter_experimental_versions) const -> Version const*
-{
-    return std::visit(
+    auto const        state   = _state.snapshot();
+    auto const* const version = std::visit(
         Cool::overloaded{
             [&](LatestVersion) {
-                return latest_installed_version_no_locking(filter_experimental_versions);
+                return state->latest_installed_version(filter_experimental_versions);
             },
             [&](LatestInstalledVersion) {
-                return latest_installed_version_no_locking(filter_experimental_versions);
+                return state->latest_installed_version(filter_experimental_versions);
             },
             [&](VersionName const& name) {
-                return find(name, filter_experimental_versions);
+                return state->find(name, filter_experimental_versions);
             }
         },
         version_ref
     );
-}
-
-void VersionManager::with_version_found(VersionName const& name, bool filter_experimental_versions, std::function<void(Version&)> const& callback)
-{
-    // auto lock = std::unique_lock{_mutex};
-
-    auto* const version = find_no_locking(name, filter_experimental_versions);
-    if (version == nullptr)
-    {
-        assert(false);
-        return;
-    }
-
-    callback(*version);
-}
-
-void VersionManager::with_version_found_or_created(VersionName const& name, bool filter_experimental_versions, std::function<void(Version&)> const& callback)
-{
-    // auto lock = std::unique_lock{_mutex};
-
-    auto* version = find_no_locking(name, filter_experimental_versions);
-    if (version == nullptr)
-    {
-        auto const new_version = Version{name, InstallationStatus::NotInstalled};
-        // Make sure to keep the vector sorted:
-        version = &*_versions.insert(std::lower_bound(_versions.begin(), _versions.end(), new_version), new_version);
-    }
-
-    callback(*version);
+    return std::shared_ptr<Version const>{state, version};
 }
 
 auto VersionManager::has_at_least_one_version_installed(bool filter_experimental_versions) const -> bool
 {
-    // auto lock = std::shared_lock{_mutex};
-
-    auto filtered_versions = versions(filter_experimental_versions);
-    return std::any_of(filtered_versions.begin(), filtered_versions.end(), [&](Version const& version) {
-        return version.installation_status == InstallationStatus::Installed;
-    });
-}
-
-void VersionManager::set_download_url(VersionName const& name, std::string download_url)
-{
-    with_version_found_or_created(name, false /*filter_experimental_versions*/, [&](Version& version) {
-        assert(!version.download_url.has_value());
-        version.download_url = std::move(download_url);
-    });
+    auto const state = _state.snapshot();
+    return state->latest_installed_version(filter_experimental_versions) != nullptr;
 }
 
-void VersionManager::set_changelog_url(VersionName const& name, std::string changelog_url)
+void VersionManager::modify_versions(std::function<void(std::vector<Version>&)> const& callback)
 {
-    with_version_found_or_created(name, false /*  filter_experimental_versions */, [&](Version& version) {
-        assert(!version.changelog_url.has_value());
-        version.changelog_url = std::move(changelog_url);
+    _state.modify([&](State& state) {
+        callback(state.versions);
+        state.update_cache();
     });
+    _generation++; // After publishing the new versions, so that nothing cached with the new generation can have been computed from the old versions
 }
 
 void VersionManager::set_installation_status(VersionName const& name, InstallationStatus installation_status)
 {
-    with_version_found_or_created(name, false /* filter_experimental_versions */, [&](Version& version) {
-        version.installation_status = installation_status;
+    modify_versions([&](std::vector<Version>& versions) {
+        auto const [begin, end] = std::equal_range(versions.begin(), versions.end(), Version{name});
+        auto       it           = std::find_if(begin, end, [&](Version const& version) { return version.name == name; });
+        if (it == end)
+            it = versions.insert(end, Version{name}); // Make sure to keep the vector sorted
+        if (it->installation_status == installation_status)
+            return;
+        auto const was_installed = it->installation_status == InstallationStatus::Installed;
+        it->installation_status  = installation_status;
+        if (was_installed || installation_status == InstallationStatus::Installed)
+            save_installed_versions(installed_version_names(versions)); // While modifying the versions, so that two concurrent modifications can't save their lists in the wrong order
     });
     if (installation_status == InstallationStatus::Installed || installation_status == InstallationStatus::NotInstalled)
     {
-        auto const it = _install_tasks.find(name);
-        if (it != _install_tasks.end())
-            _install_tasks.erase(it);
+        auto lock = std::unique_lock{_install_tasks_mutex};
+        _install_tasks.erase(name);
     }
 }
 
-void VersionManager::on_finished_fetching_list_of_versions()
+void VersionManager::on_finished_fetching_list_of_versions(ReleaseCatalog const& catalog)
 {
+    modify_versions([&](std::vector<Version>& versions) {
+        merge_release_catalog(versions, catalog);
+    });
+    save_release_catalog(catalog);
     _status_of_fetch_list_of_versions.store(Status::Completed);
 
     if (launcher_settings().automatically_install_latest_version)
         install_latest_version(true /*filter_experimental_versions*/);
 }
 
-auto VersionManager::is_installed(VersionName const& version_name, bool filter_experimental_versions) const -> bool
+auto VersionManager::installation_statuses() const -> std::map<VersionName, InstallationStatus>
 {
-    auto const* const version = find(version_name, filter_experimental_versions);
-    if (!version)
-        return false;
-    return version->installation_status == InstallationStatus::Installed;
+    auto const state = _state.snapshot();
+    auto       res   = std::map<VersionName, InstallationStatus>{};
+    for (auto const& version : state->versions)
+        res[version.name] = version.installation_status;
+    return res;
 }
 
-auto VersionManager::latest_version(bool filter_experimental_versions) const -> Version const*
+static auto status_before_scan(std::map<VersionName, InstallationStatus> const& statuses_before_scan, VersionName const& name) -> InstallationStatus
 {
-    // auto lock = std::unique_lock{_mutex};
-    return latest_version_no_locking(filter_experimental_versions);
+    auto const it = statuses_before_scan.find(name);
+    return it != statuses_before_scan.end() ? it->second : InstallationStatus::NotInstalled;
 }
 
-auto VersionManager::latest_version_no_locking(bool filter_experimental_versions) const -> Version const*
+static void apply_scan(std::vector<Version>& versions, std::vector<VersionName> const& installed_versions, std::map<VersionName, InstallationStatus> const& statuses_before_scan)
 {
-    auto filtered_versions = versions(filter_experimental_versions);
-    if (filtered_versions.empty())
-        return nullptr;
-    return &filtered_versions.front();
+    for (auto& version : versions)
+    {
+        if (version.installation_status == InstallationStatus::Installing) // The scan might have seen it half-installed. It will be saved once its install finishes
+            continue;
+        if (version.installation_status != status_before_scan(statuses_before_scan, version.name)) // It has been installed or uninstalled while we were scanning, so the scan is outdated for that version
+            continue;
+        version.installation_status = std::binary_search(installed_versions.begin(), installed_versions.end(), version.name)
+                                          ? InstallationStatus::Installed
+                                          : InstallationStatus::NotInstalled;
+    }
+    for (auto const& name : installed_versions) // Versions we didn't know about
+    {
+        auto const [begin, end] = std::equal_range(versions.begin(), versions.end(), Version{name});
+        if (std::find_if(begin, end, [&](Version const& version) { return version.name == name; }) == end)
+            versions.insert(end, Version{name, InstallationStatus::Installed});
+    }
+    std::erase_if(versions, [](Version const& version) { // Versions that are neither installed nor available online anymore
+        return version.installation_status == InstallationStatus::NotInstalled && !version.download_url.has_value();
+    });
 }
 
-auto VersionManager::latest_installed_version_no_locking(bool filter_experimental_versions) const -> Version const*
+void VersionManager::on_finished_scanning_installed_versions(std::vector<VersionName> const& installed_versions, std::map<VersionName, InstallationStatus> const& statuses_before_scan)
 {
-    // Versions are sorted from latest to oldest so the first one we find will be the latest
-    auto filtered_versions = versions(filter_experimental_versions);
-
-    auto const it = std::find_if(filtered_versions.begin(), filtered_versions.end(), [](Version const& version) {
-        return version.installation_status == InstallationStatus::Installed;
+    modify_versions([&](std::vector<Version>& versions) {
+        apply_scan(versions, installed_versions, statuses_before_scan);
+        save_installed_versions(installed_version_names(versions));
     });
-    if (it == filtered_versions.end())
-        return nullptr;
-    return &*it;
 }
 
-auto VersionManager::latest_version_with_download_url_no_locking(bool filter_experimental_versions) const -> Version const*
+auto VersionManager::is_installed(VersionName const& version_name, bool filter_experimental_versions) const -> bool
 {
-    // Versions are sorted from latest to oldest so the first one we find will be the latest
-    auto filtered_versions = versions(filter_experimental_versions);
+    auto const version = find(version_name, filter_experimental_versions);
+    if (!version)
+        return false;
+    return version->installation_status == InstallationStatus::Installed;
+}
 
-    auto const it = std::find_if(filtered_versions.begin(), filtered_versions.end(), [](Version const& version) {
-        return version.download_url.has_value();
-    });
-    if (it == filtered_versions.end())
-        return nullptr;
-    return &*it;
+auto VersionManager::latest_version(bool filter_experimental_versions) const -> std::shared_ptr<Version const>
+{
+    auto const        state   = _state.snapshot();
+    auto const* const version = state->latest_version(filter_experimental_versions);
+    return std::shared_ptr<Version const>{state, version};
+}
+
+auto VersionManager::closest_installed_version(VersionName const& name) const -> std::optional<VersionName>
+{
+    auto const state                 = _state.snapshot();
+    auto       closest_newer_version = std::optional<VersionName>{};
+    // Versions are sorted from latest to oldest
+    for (auto const& version : state->versions)
+    {
+        if (version.installation_status != InstallationStatus::Installed || version.name == name)
+            continue;
+        if (version.name < name)
+            return version.name;
+        closest_newer_version = version.name;
+    }
+    return closest_newer_version;
 }
 
 void VersionManager::imgui_manage_versions()
 {
-    // auto lock = std::unique_lock{_mutex};
+    auto const state = _state.snapshot(); // Even if the versions get modified while we are displaying them, ours won't change
 
-    auto filtered_versions = versions(true /*filter_experimental_versions*/);
-    for (auto& version : filtered_versions)
+    for (auto const& version : filtered(state->versions, true /*filter_experimental_versions*/))
     {
-        ImGui::PushID(&version);
+        ImGui::PushID(version.name.as_string_raw().c_str()); // Not the address of the version, because it changes each time the versions are modified
         ImGui::BeginGroup();
         ImGui::SeparatorText(version.name.as_string_pretty().c_str());
         if (version.changelog_url.has_value())
@@ -389,12 +528,12 @@ void VersionManager::imgui_manage_versions()
         }
         Cool::ImGuiExtras::disabled_if(version.installation_status != InstallationStatus::NotInstalled, version.installation_status == InstallationStatus::Installing ? "Installing" : "Already installed", [&]() {
             if (ImGui::Button("Install"))
-                install(version);
+                install(version, InstallPriority::UserInitiated);
         });
         ImGui::SameLine();
         Cool::ImGuiExtras::disabled_if(version.installation_status != InstallationStatus::Installed, version.installation_status == InstallationStatus::Installing ? "Installing" : "Not installed yet", [&]() {
             if (ImGui::Button("Uninstall"))
-                uninstall(version);
+                uninstall(version.name);
         });
         ImGui::EndGroup();
         if (ImGui::BeginPopupContextItem("##version_context_menu"))
@@ -411,16 +550,17 @@ void VersionManager::imgui_manage_versions()
 
 auto VersionManager::label(VersionRef const& ref, bool filter_experimental_versions) const -> std::string
 {
+    auto const state = _state.snapshot();
     return std::visit(
         Cool::overloaded{
             [&](LatestInstalledVersion) {
-                auto const* version = latest_installed_version_no_locking(filter_experimental_versions);
+                auto const* version = state->latest_installed_version(filter_experimental_versions);
                 if (!version)
-                    version = latest_version_no_locking(filter_experimental_versions);
+                    version = state->latest_version(filter_experimental_versions);
                 return fmt::format("Latest Installed ({})", version ? version->name.as_string_pretty() : "None");
             },
             [&](LatestVersion) {
-                auto const* const version = latest_version_no_locking(filter_experimental_versions);
+                auto const* const version = state->latest_version(filter_experimental_versions);
                 return fmt::format("Latest ({})", version ? version->name.as_string_pretty() : "None");
             },
             [](VersionName const& name) {
@@ -433,7 +573,7 @@ auto VersionManager::label(VersionRef const& ref, bool filter_experimental_versi
 
 void VersionManager::imgui_versions_dropdown(VersionRef& ref)
 {
-    // auto lock = std::shared_lock{_mutex};
+    auto const state = _state.snapshot();
 
     class DropdownEntry_VersionRef {
     public:
@@ -466,8 +606,146 @@ void VersionManager::imgui_versions_dropdown(VersionRef& ref)
         DropdownEntry_VersionRef{LatestInstalledVersion{}, &ref},
         DropdownEntry_VersionRef{LatestVersion{}, &ref},
     };
-    auto filtered_versions = versions(true /*filter_experimental_versions*/);
-    for (auto const& version : filtered_versions)
+    for (auto const& version : filtered(state->versions, true /*filter_experimental_versions*/))
         entries.emplace_back(version.name, &ref);
     Cool::ImGuiExtras::dropdown("Version", label(ref, true /*filter_experimental_versions*/).c_str(), entries);
-}
\ No newline at end of file
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include <thread>
+#include "doctest/doctest.h"
+
+struct VersionManagerTests {
+    static auto make(std::vector<Version> versions) -> VersionManager { return VersionManager{std::move(versions)}; }
+    static auto snapshot(VersionManager const& manager) { return manager._state.snapshot(); }
+    static void modify_versions(VersionManager& manager, std::function<void(std::vector<Version>&)> const& callback) { manager.modify_versions(callback); }
+    static void set_installation_status(VersionManager& manager, VersionName const& name, InstallationStatus status) { manager.set_installation_status(name, status); }
+    static auto latest_installing_version(VersionManager const& manager) { return manager.get_latest_installing_version_if_any(); }
+};
+
+TEST_CASE("Applying a scan of the installed versions doesn't overwrite the changes made during the scan")
+{
+    auto const version = [](std::string const& name) {
+        return *VersionName::from(name);
+    };
+    auto const url      = std::optional<std::string>{"https://example.com"};
+    auto       versions = std::vector<Version>{
+        Version{version("1.3.0"), InstallationStatus::NotInstalled, url},
+        Version{version("1.2.0"), InstallationStatus::Installed, url},
+        Version{version("1.1.0"), InstallationStatus::Installed, url},
+        Version{version("1.0.0"), InstallationStatus::NotInstalled, url},
+    };
+    auto const statuses_before_scan = std::map<VersionName, InstallationStatus>{
+        {version("1.3.0"), InstallationStatus::NotInstalled},
+        {version("1.2.0"), InstallationStatus::Installing},
+        {version("1.1.0"), InstallationStatus::Installed},
+        {version("1.0.0"), InstallationStatus::Installed},
+    };
+    // During the scan, 1.2.0 finished installing and 1.0.0 got uninstalled. The scan saw 1.2.0 half-installed, 1.0.0 still there, and 1.3.0 that the user copied manually
+    apply_scan(versions, {version("1.0.0"), version("1.1.0"), version("1.3.0")}, statuses_before_scan);
+    CHECK(versions[0].installation_status == InstallationStatus::Installed);
+    CHECK(versions[1].installation_status == InstallationStatus::Installed);
+    CHECK(versions[2].installation_status == InstallationStatus::Installed);
+    CHECK(versions[3].installation_status == InstallationStatus::NotInstalled);
+}
+
+TEST_CASE("VersionManager readers always see consistent versions while tasks modify them")
+{
+    static constexpr int nb_versions          = 50;
+    static constexpr int nb_writes_per_writer = 300;
+    static constexpr int nb_readers           = 3;
+
+    auto const version = [](int minor, int patch) {
+        return *VersionName::from(fmt::format("1.{}.{}", minor, patch));
+    };
+    auto versions = std::vector<Version>{};
+    for (int i = nb_versions - 1; i >= 0; --i) // From latest to oldest
+        versions.push_back(Version{version(0, i), i == 0 ? InstallationStatus::Installed : InstallationStatus::NotInstalled});
+    auto manager = VersionManagerTests::make(std::move(versions));
+
+    auto is_done = std::atomic<bool>{false};
+    auto errors  = std::atomic<int>{0};
+    auto readers = std::vector<std::thread>{};
+    for (int i = 0; i < nb_readers; ++i)
+    {
+        readers.emplace_back([&]() {
+            while (!is_done.load())
+            {
+                // Like the UI, which goes through all the versions of a snapshot
+                auto const        state            = VersionManagerTests::snapshot(manager);
+                auto const* const latest_installed = state->latest_installed_version(false);
+                if (!std::is_sorted(state->versions.begin(), state->versions.end())
+                    || state->latest_version(false) != &state->versions.front()
+                    || !latest_installed || latest_installed->installation_status != InstallationStatus::Installed
+                    || std::any_of(state->versions.data(), latest_installed, [](Version const& ver) { return ver.installation_status == InstallationStatus::Installed; }))
+                {
+                    errors++;
+                }
+
+                // Like the tasks and the projects, which only ask for one version at a time
+                auto const installed = manager.find_installed_version(LatestInstalledVersion{}, false);
+                auto const found     = manager.find(version(0, nb_versions / 2), false);
+                if (!installed || installed->installation_status != InstallationStatus::Installed
+                    || !found || found->name != version(0, nb_versions / 2)
+                    || !manager.latest_version(false)
+                    || !manager.is_installed(version(0, 0), false)
+                    || !manager.closest_installed_version(version(2, 0)).has_value()
+                    || manager.label(LatestInstalledVersion{}, false).find("None") != std::string::npos
+                    || VersionManagerTests::latest_installing_version(manager) != nullptr)
+                {
+                    errors++;
+                }
+            }
+        });
+    }
+
+    auto writers = std::vector<std::thread>{};
+    // Installs and cancels the even versions, which also goes through the mutex of the install tasks
+    writers.emplace_back([&]() {
+        for (int j = 0; j < nb_writes_per_writer; ++j)
+        {
+            auto const name = version(0, 2 * (j % (nb_versions / 2)));
+            if (name == version(0, 0))
+                continue; // Stays installed
+            VersionManagerTests::set_installation_status(manager, name, InstallationStatus::Installing);
+            VersionManagerTests::set_installation_status(manager, name, InstallationStatus::NotInstalled);
+        }
+    });
+    // Marks the odd versions as installed and uninstalled, like a scan of the installation folder would
+    writers.emplace_back([&]() {
+        for (int j = 0; j < nb_writes_per_writer; ++j)
+        {
+            auto const name = version(0, 2 * (j % (nb_versions / 2)) + 1);
+            VersionManagerTests::modify_versions(manager, [&](std::vector<Version>& versions) {
+                auto const it           = std::find(versions.begin(), versions.end(), Version{name});
+                it->installation_status = it->installation_status == InstallationStatus::Installed ? InstallationStatus::NotInstalled : InstallationStatus::Installed;
+            });
+        }
+    });
+    // Adds and removes newer versions, like fetching the list of versions would
+    writers.emplace_back([&]() {
+        for (int j = 0; j < nb_writes_per_writer; ++j)
+        {
+            auto const name = version(1, j);
+            VersionManagerTests::modify_versions(manager, [&](std::vector<Version>& versions) {
+                versions.insert(std::lower_bound(versions.begin(), versions.end(), Version{name}), Version{name});
+            });
+            VersionManagerTests::modify_versions(manager, [&](std::vector<Version>& versions) {
+                std::erase(versions, Version{name});
+            });
+        }
+    });
+
+    for (auto& writer : writers)
+        writer.join();
+    is_done.store(true);
+    for (auto& reader : readers)
+        reader.join();
+
+    CHECK(errors.load() == 0);
+    auto const state = VersionManagerTests::snapshot(manager);
+    CHECK(state->versions.size() == static_cast<size_t>(nb_versions));
+    CHECK(std::count_if(state->versions.begin(), state->versions.end(), [](Version const& ver) { return ver.installation_status != InstallationStatus::NotInstalled; }) == 1); // Each odd version has been marked as installed an even number of times
+    CHECK(state->latest_installed_version(false) == &state->versions.back());
+}
+#endif
@@ -1,17 +1,23 @@
 #pragma once
 #include <ImGuiNotify/ImGuiNotify.hpp>
 #include <map>
+#include <mutex>
 #include <tl/expected.hpp>
 #include "Cool/Task/Task.hpp"
-#include "Cool/Task/WaitToExecuteTask.hpp"
+#include "CopyOnWrite/CopyOnWrite.hpp"
+#include "InstallScheduler.hpp"
 #include "LauncherSettings.hpp"
 #include "ProjectToOpenOrCreate.hpp"
+#include "ReleaseCatalog.hpp"
 #include "Status.hpp"
 #include "Version.hpp"
 #include "VersionName.hpp"
 #include "VersionRef.hpp"
-#include "range/v3/view.hpp"
 
+class Task_InstallVersion;
+
+/// Can be used from any thread.
+/// The versions returned are snapshots: they stay valid for as long as you hold them, but won't see the changes made after you got them.
 class VersionManager {
 public:
     VersionManager();
@@ -22,56 +28,80 @@ public:
     void imgui_manage_versions();
     void imgui_versions_dropdown(VersionRef&);
 
-    auto find(VersionName const& name, bool filter_experimental_versions) const -> Version const*;
-    auto find_installed_version(VersionRef const&, bool filter_experimental_versions) const -> Version const*;
-    auto latest_version(bool filter_experimental_versions) const -> Version const*;
+    auto find(VersionName const& name, bool filter_experimental_versions) const -> std::shared_ptr<Version const>;
+    auto find_installed_version(VersionRef const&, bool filter_experimental_versions) const -> std::shared_ptr<Version const>;
+    auto latest_version(bool filter_experimental_versions) const -> std::shared_ptr<Version const>;
     auto status_of_fetch_list_of_versions() const -> Status { return _status_of_fetch_list_of_versions.load(); }
+    /// True iff we know which versions are available online, either because we fetched the list, or because we loaded the one we saved last time
+    auto has_list_of_versions() const -> bool { return _has_release_catalog || status_of_fetch_list_of_versions() == Status::Completed; }
     auto is_installed(VersionName const&, bool filter_experimental_versions) const -> bool;
+    /// The installed version that is the most likely to share a lot of content with the given one: the latest installed version older than it, or if there is none the oldest installed version newer than it
+    auto closest_installed_version(VersionName const&) const -> std::optional<VersionName>;
 
     auto label(VersionRef const&, bool filter_experimental_versions) const -> std::string;
+    /// Changes each time the versions are modified, so that you can cache things that depend on them
+    auto generation() const -> uint64_t { return _generation.load(); }
 
 private:
-    auto find_no_locking(VersionName const&, bool filter_experimental_versions) -> Version*;
-    auto find_no_locking(VersionName const&, bool filter_experimental_versions) const -> Version const*;
-    auto latest_version_no_locking(bool filter_experimental_versions) const -> Version const*;
-    auto latest_installed_version_no_locking(bool filter_experimental_versions) const -> Version const*;
-    auto latest_version_with_download_url_no_locking(bool filter_experimental_versions) const -> Version const*;
-
-    void with_version_found(VersionName const& name, bool filter_experimental_versions, std::function<void(Version&)> const& callback);
-    void with_version_found_or_created(VersionName const& name, bool filter_experimental_versions, std::function<void(Version&)> const& callback);
-    auto has_at_least_one_version_installed(bool filter_experimental_versions) const -> bool;
-    auto get_latest_installing_version_if_any() const -> std::shared_ptr<Cool::Task>;
+    friend struct VersionManagerTests;
+    /// Starts with the given versions, and doesn't scan nor fetch anything in the background
+    explicit VersionManager(std::vector<Version> versions);
+
+    struct State {
+        /// Indices in `versions`, because pointers would be invalidated when the State is copied
+        struct Latest {
+            std::optional<size_t> version{};
+            std::optional<size_t> installed_version{};
+            std::optional<size_t> version_with_download_url{};
+        };
+
+        std::vector<Version>  versions{}; // Sorted, from latest to oldest version
+        std::array<Latest, 2> latest{};   // [0] among all the versions, [1] among the non-experimental versions
+
+        /// Must be called after each modification of the versions
+        void update_cache();
 
-    void install(Version const&);
-    void uninstall(Version&);
+        auto find(VersionName const&, bool filter_experimental_versions) const -> Version const*;
+        auto latest_version(bool filter_experimental_versions) const -> Version const*;
+        auto latest_installed_version(bool filter_experimental_versions) const -> Version const*;
+        auto latest_version_with_download_url(bool filter_experimental_versions) const -> Version const*;
+
+    private:
+        auto get(std::optional<size_t> index) const -> Version const*;
+    };
+
+    void modify_versions(std::function<void(std::vector<Version>&)> const&);
+
+    auto has_at_least_one_version_installed(bool filter_experimental_versions) const -> bool;
+    auto get_latest_installing_version_if_any() const -> std::shared_ptr<Task_InstallVersion>;
 
-    auto after_version_installed(VersionRef const& version_ref) -> std::shared_ptr<Cool::WaitToExecuteTask>;
-    auto get_install_task_or_create_and_submit_it(VersionName const&) -> std::shared_ptr<Cool::Task>;
+    void install(Version const&, InstallPriority);
+    void uninstall(VersionName const&);
 
-    auto versions(bool filter_experimental_versions) const
-    {
-        return _versions | ranges::views::filter([filter_experimental_versions](Version const& version) { return !version.name.is_experimental() || !filter_experimental_versions || launcher_settings().show_experimental_versions; });
-    }
-    auto versions(bool filter_experimental_versions)
-    {
-        return _versions | ranges::views::filter([filter_experimental_versions](Version const& version) { return !version.name.is_experimental() || !filter_experimental_versions || launcher_settings().show_experimental_versions; });
-    }
+    /// The install task that must complete before we can launch the given version, or nullptr if we can launch it right away
+    auto install_task_to_wait_for(VersionRef const&) -> std::shared_ptr<Task_InstallVersion>;
+    auto get_install_task_or_create_and_submit_it(VersionName const&, InstallPriority) -> std::shared_ptr<Task_InstallVersion>;
+    void submit_install_task(std::shared_ptr<Task_InstallVersion> const&);
 
 private:
     friend class Task_FetchListOfVersions;
     friend class Task_InstallVersion;
+    friend class Task_ScanInstalledVersions;
 
-    void set_download_url(VersionName const&, std::string download_url);
-    void set_changelog_url(VersionName const&, std::string changelog_url);
     void set_installation_status(VersionName const&, InstallationStatus);
-    void on_finished_fetching_list_of_versions();
+    void on_finished_fetching_list_of_versions(ReleaseCatalog const&);
+    /// Must be read before scanning the installed versions, so that applying the scan doesn't overwrite the installs and uninstalls that happened during the scan
+    auto installation_statuses() const -> std::map<VersionName, InstallationStatus>;
+    void on_finished_scanning_installed_versions(std::vector<VersionName> const&, std::map<VersionName, InstallationStatus> const& statuses_before_scan);
 
 private:
-    std::vector<Version> _versions{}; // Sorted, from latest to oldest version
-    // mutable std::shared_mutex _mutex{};
+    CopyOnWrite<State>    _state{}; // Read every frame by the UI, and modified by the tasks
+    std::atomic<uint64_t> _generation{0};
+    bool                  _has_release_catalog{false};
 
-    std::atomic<Status>                                _status_of_fetch_list_of_versions{Status::Waiting};
-    std::map<VersionName, std::shared_ptr<Cool::Task>> _install_tasks{};
+    std::atomic<Status>                                         _status_of_fetch_list_of_versions{Status::Waiting};
+    std::map<VersionName, std::shared_ptr<Task_InstallVersion>> _install_tasks{};
+    mutable std::mutex                                          _install_tasks_mutex{};
 };
 
 inline auto version_manager() -> VersionManager&
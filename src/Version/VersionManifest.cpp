@@ -0,0 +1,97 @@
+#include "VersionManifest.hpp"
+#include <fstream>
+#include "Cool/File/File.h"
+#include "Cool/Serialization/Json.hpp"
+#include "Path.hpp"
+#include "nlohmann/json.hpp"
+
+static auto manifest_path(VersionName const& name) -> std::filesystem::path
+{
+    return Path::version_manifests_folder() / (name.as_string_raw() + ".json");
+}
+
+static auto relative_path(std::filesystem::path const& installation_folder, std::filesystem::path const& file) -> std::string
+{
+    return file.lexically_relative(installation_folder).generic_string(); // Use generic_string() so that the manifest is the same on all platforms
+}
+
+static auto current_state(std::filesystem::path const& file) -> std::optional<VersionManifest::File>
+{
+    auto       error_code = std::error_code{};
+    auto const size       = std::filesystem::file_size(file, error_code);
+    if (error_code)
+        return std::nullopt;
+    auto const last_write_time = std::filesystem::last_write_time(file, error_code);
+    if (error_code)
+        return std::nullopt;
+    return VersionManifest::File{
+        .size            = size,
+        .last_write_time = static_cast<int64_t>(last_write_time.time_since_epoch().count()),
+    };
+}
+
+auto VersionManifest::known_sha256(std::filesystem::path const& installation_folder, std::filesystem::path const& file) const -> std::optional<std::string>
+{
+    auto const it = files.find(relative_path(installation_folder, file));
+    if (it == files.end())
+        return std::nullopt;
+    auto const state = current_state(file);
+    if (!state || state->size != it->second.size || state->last_write_time != it->second.last_write_time)
+        return std::nullopt;
+    return it->second.sha256;
+}
+
+void VersionManifest::set_sha256(std::filesystem::path const& installation_folder, std::filesystem::path const& file, std::string sha256)
+{
+    auto state = current_state(file);
+    if (!state)
+        return;
+    state->sha256                                   = std::move(sha256);
+    files[relative_path(installation_folder, file)] = std::move(*state);
+}
+
+auto load_version_manifest(VersionName const& name) -> VersionManifest
+{
+    auto file = std::ifstream{manifest_path(name)};
+    if (!file.is_open())
+        return {};
+
+    try
+    {
+        auto const json     = nlohmann::json::parse(file);
+        auto       manifest = VersionManifest{};
+        Cool::json_get(json, "Asset SHA-256", manifest.asset_sha256);
+        Cool::json_get(json, "Asset is verified", manifest.asset_is_verified);
+        for (auto const& [path, file_json] : json.at("Files").items())
+        {
+            manifest.files[path] = VersionManifest::File{
+                .sha256          = file_json.at(0).get<std::string>(),
+                .size            = file_json.at(1).get<uint64_t>(),
+                .last_write_time = file_json.at(2).get<int64_t>(),
+            };
+        }
+        return manifest;
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("Load version manifest", e.what());
+        return {};
+    }
+}
+
+void save_version_manifest(VersionName const& name, VersionManifest const& manifest)
+{
+    auto json = nlohmann::json{};
+    Cool::json_set(json, "Asset SHA-256", manifest.asset_sha256);
+    Cool::json_set(json, "Asset is verified", manifest.asset_is_verified);
+    auto files = nlohmann::json::object();
+    for (auto const& [path, file] : manifest.files)
+        files[path] = {file.sha256, file.size, file.last_write_time};
+    json["Files"] = std::move(files);
+    Cool::File::set_content(manifest_path(name), json.dump());
+}
+
+void remove_version_manifest(VersionName const& name)
+{
+    Cool::File::remove_file(manifest_path(name));
+}
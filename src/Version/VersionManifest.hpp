@@ -0,0 +1,26 @@
+#pragma once
+#include <map>
+#include "VersionName.hpp"
+
+/// What we know about an installed version, saved next to it so that we never have to compute it twice (hashing a whole version takes a while)
+struct VersionManifest {
+    struct File {
+        std::string sha256{};
+        uint64_t    size{};
+        int64_t     last_write_time{}; // Together with the size, tells us if the file has been modified since we hashed it
+    };
+
+    std::string                 asset_sha256{};      // Of the file we downloaded (the AppImage or the zip). Computed while downloading it
+    bool                        asset_is_verified{}; // True iff the release published a checksum, and asset_sha256 matched it
+    std::map<std::string, File> files{};             // The keys are the paths relative to the installation folder
+
+    /// Returns nullopt if we never hashed that file, or if it has been modified since
+    auto known_sha256(std::filesystem::path const& installation_folder, std::filesystem::path const& file) const -> std::optional<std::string>;
+    /// Must be called once the file is in its final state, because we remember its current size and last write time
+    void set_sha256(std::filesystem::path const& installation_folder, std::filesystem::path const& file, std::string sha256);
+};
+
+/// Returns an empty manifest if there is none, or if it can't be read
+auto load_version_manifest(VersionName const&) -> VersionManifest;
+void save_version_manifest(VersionName const&, VersionManifest const&);
+void remove_version_manifest(VersionName const&);
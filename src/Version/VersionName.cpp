@@ -1,125 +1,49 @@
 #include "VersionName.hpp"
-#include <cassert>
-#include <compare>
-#include "Cool/String/String.h"
+#include <charconv>
 
-static auto is_number(char c) -> bool
+static auto parse_number(char const*& it, char const* end) -> std::optional<uint16_t>
 {
-    return '0' <= c && c <= '9';
+    auto number       = uint16_t{};
+    auto [ptr, error] = std::from_chars(it, end, number);
+    if (error != std::errc{})
+        return std::nullopt;
+    it = ptr;
+    return number;
 }
 
 auto VersionName::from(std::string name) -> std::optional<VersionName>
 {
-    if (name.empty())
-        return std::nullopt;
-
-    VersionName ver;
-    ver._raw_name        = std::move(name);
-    ver._is_experimental = ver._raw_name.find("Experimental(") != std::string::npos;
-
-    auto       acc                           = std::string{};
-    auto       nb_dots                       = 0;
-    auto const register_current_version_part = [&]() -> bool { // Returns true iff it was successful
-        try
-        {
-            int const nb = std::stoi(acc);
-            acc          = "";
-            if (nb_dots == 0)
-                ver._major = nb;
-            else if (nb_dots == 1)
-                ver._minor = nb;
-            else
-            {
-                assert(nb_dots == 2);
-                ver._patch = nb;
-            }
-            return true;
-        }
-        catch (...)
-        {
-            return false;
-        }
-    };
-
-    for (size_t i = 0; i <= ver._raw_name.size(); ++i)
+    // Parses "major[.minor[.patch]][ name part]"
+    auto const* it      = name.data();
+    auto const* end     = name.data() + name.size(); // NOLINT(*pointer-arithmetic)
+    auto        numbers = std::array<uint16_t, 3>{};
+    for (size_t i = 0; i < numbers.size(); ++i)
     {
-        if (i == ver._raw_name.size())
-        {
-            if (!register_current_version_part())
-                return std::nullopt;
-            break;
-        }
-
-        if (is_number(ver._raw_name[i]))
-        {
-            acc += ver._raw_name[i];
-        }
-        else if (ver._raw_name[i] == '.')
-        {
-            if (!register_current_version_part())
-                return std::nullopt;
-            nb_dots++;
-            if (nb_dots > 2)
-                break;
-        }
-        else if (ver._raw_name[i] == ' ')
-        {
-            if (!register_current_version_part())
-                return std::nullopt;
+        auto const number = parse_number(it, end);
+        if (!number.has_value())
+            return std::nullopt;
+        numbers[i] = *number;
+        if (it == end || *it == ' ')
             break;
-        }
-        else
-        {
+        if (*it != '.' || i == numbers.size() - 1)
             return std::nullopt;
-        }
+        ++it;
     }
 
-    {
-        auto const start = ver._raw_name.find(' ');
-        if (start == std::string::npos || start == ver._raw_name.size() - 1)
-        {
-            ver._pretty_name = ver._raw_name;
-        }
-        else
-        {
-            ver._pretty_name = Cool::String::substring(ver._raw_name, 0, start + 1) + '"'
-                               + Cool::String::substring(ver._raw_name, start + 1, ver._raw_name.size()) + '"';
-        }
-    }
+    auto const is_experimental = std::string_view{it, end}.find("Experimental(") != std::string_view::npos;
 
+    auto ver      = VersionName{};
+    ver._key      = (uint64_t{numbers[0]} << 48) | (uint64_t{numbers[1]} << 32) | (uint64_t{numbers[2]} << 16) | (is_experimental ? experimental_bit : 0);
+    ver._raw_name = std::move(name);
     return ver;
 }
 
-auto operator<=>(VersionName const& a, VersionName const& b) -> std::strong_ordering
+auto VersionName::as_string_pretty() const -> std::string
 {
-    if (a._major < b._major)
-        return std::strong_ordering::less;
-    if (b._major < a._major)
-        return std::strong_ordering::greater;
-
-    if (a._minor < b._minor)
-        return std::strong_ordering::less;
-    if (b._minor < a._minor)
-        return std::strong_ordering::greater;
-
-    if (a._patch < b._patch)
-        return std::strong_ordering::less;
-    if (b._patch < a._patch)
-        return std::strong_ordering::greater;
-
-    if (a._is_experimental && !b._is_experimental)
-        return std::strong_ordering::greater;
-    if (!a._is_experimental && b._is_experimental)
-        return std::strong_ordering::less;
-    if (!a._is_experimental && !b._is_experimental)
-        return std::strong_ordering::equal;
-
-    return a._raw_name <=> b._raw_name; // Experimental versions can have the same semantic version, and just differ by their name (eg. "1.2.0 Experimental(LED)" and "1.2.0 Experimental(WebGPU)")
-}
-
-auto operator==(VersionName const& a, VersionName const& b) -> bool
-{
-    return a._raw_name == b._raw_name;
+    auto const start = _raw_name.find(' ');
+    if (start == std::string::npos || start == _raw_name.size() - 1)
+        return _raw_name;
+    return fmt::format("{}\"{}\"", std::string_view{_raw_name}.substr(0, start + 1), std::string_view{_raw_name}.substr(start + 1));
 }
 
 #if defined(COOLLAB_LAUNCHER_TESTS)
@@ -171,5 +95,75 @@ TEST_CASE("Parsing Coollab Version from string")
         CHECK(version->minor() == 71);
         CHECK(version->patch() == 3);
     }
+    SUBCASE("")
+    {
+        CHECK(!VersionName::from("Beta 18").has_value());
+        CHECK(!VersionName::from("1..2").has_value());
+        CHECK(!VersionName::from("1.2.").has_value());
+        CHECK(!VersionName::from("1.2.3.4").has_value());
+        CHECK(!VersionName::from("-1.2.3").has_value());
+        CHECK(!VersionName::from("1.2.3-rc").has_value());
+        CHECK(!VersionName::from("70000.0.0").has_value());
+        CHECK(!VersionName::from("").has_value());
+    }
+    SUBCASE("")
+    {
+        CHECK(VersionName::from("5.71.3 Experimental(LED)")->as_string_pretty() == "5.71.3 \"Experimental(LED)\"");
+        CHECK(VersionName::from("5.71.3")->as_string_pretty() == "5.71.3");
+    }
+}
+
+TEST_CASE("Comparing Coollab Versions")
+{
+    auto const version = [](std::string const& name) {
+        return *VersionName::from(name);
+    };
+    CHECK(version("1.2.3") < version("1.2.4"));
+    CHECK(version("1.2.3") < version("1.3.0"));
+    CHECK(version("1.9.9") < version("2.0.0"));
+    CHECK(version("1.10.0") > version("1.9.0"));
+    CHECK(version("1.2.3") < version("1.2.3 Experimental(LED)"));
+    CHECK(version("1.2.3 Experimental(LED)") < version("1.2.4"));
+    CHECK(version("1.2.3 Experimental(LED)") != version("1.2.3 Experimental(WebGPU)"));
+    CHECK(version("1.2.3 Experimental(LED)") < version("1.2.3 Experimental(WebGPU)"));
+    CHECK(version("1.2.3 Experimental(WebGPU)") > version("1.2.3 Experimental(LED)"));
+    CHECK(version("1.2.3 Experimental(LED)") == version("1.2.3 Experimental(LED)"));
+    CHECK(version("1.2.3 MacOS") != version("1.2.3"));
+    CHECK(version("1.2.3") < version("1.2.3 MacOS"));
+    CHECK(version("18") != version("18.0.0"));
+    CHECK(version("18") < version("18.0.0"));
+}
+
+TEST_CASE("Benchmark: parsing and comparing Coollab Versions" * doctest::skip()) // Run it with --no-skip
+{
+    static constexpr int nb_iterations = 1'000'000;
+
+    auto names = std::vector<std::string>{};
+    for (int i = 0; i < 100; ++i)
+        names.push_back(fmt::format("{}.{}.{}{}", i % 7, i % 13, i % 5, i % 10 == 0 ? " Experimental(LED)" : ""));
+
+    auto versions = std::vector<VersionName>{};
+    {
+        auto const begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < nb_iterations; ++i)
+        {
+            auto version = VersionName::from(names[static_cast<size_t>(i) % names.size()]);
+            if (versions.size() < names.size())
+                versions.push_back(std::move(*version));
+        }
+        auto const duration = std::chrono::steady_clock::now() - begin;
+        MESSAGE(fmt::format("Parse: {} ns", std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / nb_iterations));
+    }
+    {
+        auto       nb_less = 0;
+        auto const begin   = std::chrono::steady_clock::now();
+        for (int i = 0; i < nb_iterations; ++i)
+        {
+            if (versions[static_cast<size_t>(i) % versions.size()] < versions[static_cast<size_t>(i * 7) % versions.size()])
+                nb_less++;
+        }
+        auto const duration = std::chrono::steady_clock::now() - begin;
+        MESSAGE(fmt::format("Compare: {} ns ({} less)", std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / nb_iterations, nb_less));
+    }
 }
 #endif
\ No newline at end of file
@@ -6,23 +6,28 @@ class VersionName {
 public:
     static auto from(std::string name) -> std::optional<VersionName>;
 
-    auto as_string_raw() const -> std::string { return _raw_name; }
+    auto as_string_raw() const -> std::string const& { return _raw_name; }
     /// Adds quotes around the name part, to make it nicer. But this is isn't suitable for a folder name because quotes are not allowed
-    auto as_string_pretty() const -> std::string { return _pretty_name; }
+    auto as_string_pretty() const -> std::string;
 
-    auto major() const -> int { return _major; };
-    auto minor() const -> int { return _minor; };
-    auto patch() const -> int { return _patch; };
-    auto is_experimental() const -> bool { return _is_experimental; }
+    auto major() const -> int { return static_cast<int>((_key >> 48) & 0xFFFF); };
+    auto minor() const -> int { return static_cast<int>((_key >> 32) & 0xFFFF); };
+    auto patch() const -> int { return static_cast<int>((_key >> 16) & 0xFFFF); };
+    auto is_experimental() const -> bool { return (_key & experimental_bit) != 0; }
 
-    friend auto operator<=>(VersionName const&, VersionName const&) -> std::strong_ordering;
-    friend auto operator==(VersionName const&, VersionName const&) -> bool;
+    friend auto operator<=>(VersionName const& a, VersionName const& b) -> std::strong_ordering
+    {
+        if (auto const order = a._key <=> b._key; order != 0)
+            return order;
+        return a._raw_name <=> b._raw_name; // Versions can have the same numbers, and just differ by their name (e.g. "1.2.0 Experimental(LED)" and "1.2.0 Experimental(WebGPU)")
+    }
+    friend auto operator==(VersionName const& a, VersionName const& b) -> bool { return a._key == b._key && a._raw_name == b._raw_name; }
 
 private:
+    static constexpr uint64_t experimental_bit{1 << 15};
+
     std::string _raw_name{};
-    std::string _pretty_name{};
-    int         _major{0};
-    int         _minor{0};
-    int         _patch{0};
-    bool        _is_experimental{false};
-};
\ No newline at end of file
+    /// The numbers, packed in one integer so that most comparisons don't need to look at the strings: | major (16 bits) | minor (16 bits) | patch (16 bits) | is_experimental (1 bit) | unused (15 bits) |
+    /// Experimental versions come after the regular ones
+    uint64_t _key{0};
+};
@@ -22,4 +22,9 @@ static auto exe_name() -> std::filesystem::path
 auto executable_path(VersionName const& name) -> std::filesystem::path
 {
     return installation_path(name) / exe_name();
-}
\ No newline at end of file
+}
+
+auto download_path(VersionName const& name) -> std::filesystem::path
+{
+    return Path::downloads_folder() / (name.as_string_raw() + ".part");
+}
@@ -2,4 +2,6 @@
 #include "VersionName.hpp"
 
 auto installation_path(VersionName const& name) -> std::filesystem::path;
-auto executable_path(VersionName const& name) -> std::filesystem::path;
\ No newline at end of file
+auto executable_path(VersionName const& name) -> std::filesystem::path;
+/// File where the release is downloaded to, before being installed
+auto download_path(VersionName const& name) -> std::filesystem::path;
@@ -0,0 +1,232 @@
+#include "parse_releases.hpp"
+#include "nlohmann/json.hpp"
+
+/// Github publishes the checksum of each asset, as "sha256:<hash>" (older releases don't have it)
+static auto published_sha256(std::string const& digest) -> std::optional<std::string>
+{
+    if (!digest.starts_with("sha256:"))
+        return std::nullopt;
+    return digest.substr("sha256:"s.size());
+}
+
+/// Only looks at the fields we need, and ignores everything else
+/// The json is an array of releases, each of them containing an array of assets:
+/// depth 1: the array of releases
+/// depth 2: a release
+/// depth 3: the array of assets of a release
+/// depth 4: an asset
+class ReleasesParser : public nlohmann::json_sax<nlohmann::json> {
+public:
+    ReleasesParser(std::string const& asset_name, std::function<bool()> const& wants_to_cancel)
+        : _asset_name{asset_name}
+        , _wants_to_cancel{wants_to_cancel}
+    {}
+
+    auto releases() && -> std::vector<ReleaseCatalog::Release> { return std::move(_releases); }
+    auto error() const -> std::string const& { return _error; }
+
+    auto start_object(std::size_t) -> bool override
+    {
+        _depth++;
+        if (_depth == 2)
+            _release = {};
+        else if (_depth == 4 && _is_in_assets)
+            _asset = {};
+        return true;
+    }
+
+    auto end_object() -> bool override
+    {
+        if (_depth == 4 && _is_in_assets)
+            on_asset_parsed();
+        else if (_depth == 2)
+            on_release_parsed();
+        _depth--;
+        if (_wants_to_cancel())
+        {
+            _error = "Canceled";
+            return false;
+        }
+        return true;
+    }
+
+    auto start_array(std::size_t) -> bool override
+    {
+        _depth++;
+        if (_depth == 3 && _key == "assets")
+            _is_in_assets = true;
+        return true;
+    }
+
+    auto end_array() -> bool override
+    {
+        if (_depth == 3)
+            _is_in_assets = false;
+        _depth--;
+        return true;
+    }
+
+    auto key(string_t& key) -> bool override
+    {
+        _key = std::move(key);
+        return true;
+    }
+
+    auto string(string_t& value) -> bool override
+    {
+        if (_depth == 2)
+        {
+            if (_key == "name")
+                _release.name = std::move(value);
+            else if (_key == "tag_name")
+                _release.tag = std::move(value);
+        }
+        else if (_depth == 4 && _is_in_assets)
+        {
+            if (_key == "name")
+                _asset.name = std::move(value);
+            else if (_key == "browser_download_url")
+                _asset.url = std::move(value);
+            else if (_key == "digest")
+                _asset.digest = std::move(value);
+        }
+        return true;
+    }
+
+    auto boolean(bool value) -> bool override
+    {
+        if (_depth == 2 && _key == "draft")
+            _release.is_draft = value;
+        return true;
+    }
+
+    auto null() -> bool override { return true; }
+    auto number_integer(number_integer_t) -> bool override { return true; }
+    auto number_unsigned(number_unsigned_t) -> bool override { return true; }
+    auto number_float(number_float_t, string_t const&) -> bool override { return true; }
+    auto binary(binary_t&) -> bool override { return true; }
+
+    auto parse_error(std::size_t, std::string const&, nlohmann::detail::exception const& exception) -> bool override
+    {
+        _error = exception.what();
+        return false;
+    }
+
+private:
+    void on_asset_parsed()
+    {
+        if (_asset.name == _asset_name)
+        {
+            _release.download_url = std::move(_asset.url);
+            _release.sha256       = published_sha256(_asset.digest);
+        }
+        else if (_asset.name == _asset_name + ".zsync")
+        {
+            _release.zsync_url = std::move(_asset.url);
+        }
+    }
+
+    void on_release_parsed()
+    {
+        if (_release.is_draft || _release.tag.empty() || !_release.download_url.has_value()) // We only list versions that have an actual executable ready to download
+            return;
+        auto const version_name = VersionName::from(_release.name);
+        if (!version_name.has_value()) // This will ignore all the old Beta versions, which is what we want because they are not compatible with the launcher
+            return;
+        _releases.push_back(ReleaseCatalog::Release{
+            .name          = *version_name,
+            .download_url  = std::move(*_release.download_url),
+            .changelog_url = fmt::format("https://github.com/Coollab-Art/Coollab/blob/{}/changelog.md", _release.tag),
+            .zsync_url     = std::move(_release.zsync_url),
+            .sha256        = std::move(_release.sha256),
+        });
+    }
+
+private:
+    struct Asset {
+        std::string name{};
+        std::string url{};
+        std::string digest{};
+    };
+    struct Release {
+        std::string                name{};
+        std::string                tag{};
+        bool                       is_draft{false};
+        std::optional<std::string> download_url{};
+        std::optional<std::string> zsync_url{};
+        std::optional<std::string> sha256{};
+    };
+
+    std::string const&           _asset_name;
+    std::function<bool()> const& _wants_to_cancel;
+
+    int         _depth{0};
+    std::string _key{};
+    bool        _is_in_assets{false};
+    Asset       _asset{};
+    Release     _release{};
+
+    std::vector<ReleaseCatalog::Release> _releases{};
+    std::string                          _error{};
+};
+
+auto parse_releases(std::string_view json, std::string const& asset_name, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<std::vector<ReleaseCatalog::Release>, std::string>
+{
+    auto parser = ReleasesParser{asset_name, wants_to_cancel};
+    if (!nlohmann::json::sax_parse(json, &parser))
+        return tl::make_unexpected(parser.error());
+
+    auto releases = std::move(parser).releases();
+    sort_releases(releases);
+    return releases;
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+
+TEST_CASE("Parsing the releases returned by Github")
+{
+    auto const json = R"json([
+        {
+            "name": "1.1.0 MacOS",
+            "tag_name": "1.1.0",
+            "draft": false,
+            "author": {"login": "someone", "name": "Not a release name"},
+            "body": "Changelog",
+            "assets": [
+                {"name": "Coollab-Windows.zip", "browser_download_url": "https://example.com/1.1.0/Coollab-Windows.zip", "size": 123},
+                {"name": "Coollab.AppImage", "browser_download_url": "https://example.com/1.1.0/Coollab.AppImage", "uploader": {"name": "Coollab.AppImage", "login": "bot"}, "digest": "sha256:abcdef"},
+                {"name": "Coollab.AppImage.zsync", "browser_download_url": "https://example.com/1.1.0/Coollab.AppImage.zsync", "digest": null}
+            ]
+        },
+        {
+            "name": "1.2.0",
+            "tag_name": "1.2.0",
+            "draft": false,
+            "assets": [
+                {"name": "Coollab.AppImage", "browser_download_url": "https://example.com/1.2.0/Coollab.AppImage", "digest": "sha1:123"}
+            ]
+        },
+        {"name": "1.3.0", "tag_name": "1.3.0", "draft": true, "assets": [{"name": "Coollab.AppImage", "browser_download_url": "https://example.com/1.3.0/Coollab.AppImage"}]},
+        {"name": "1.0.0", "tag_name": "1.0.0", "draft": false, "assets": [{"name": "Coollab-Windows.zip", "browser_download_url": "https://example.com/1.0.0/Coollab-Windows.zip"}]},
+        {"name": "Beta 18", "tag_name": "beta-18", "draft": false, "assets": [{"name": "Coollab.AppImage", "browser_download_url": "https://example.com/beta-18/Coollab.AppImage"}]}
+    ])json";
+
+    auto const releases = parse_releases(json, "Coollab.AppImage", []() { return false; });
+    REQUIRE(releases.has_value());
+    REQUIRE(releases->size() == 2);
+    CHECK((*releases)[0].name == *VersionName::from("1.2.0"));
+    CHECK((*releases)[0].download_url == "https://example.com/1.2.0/Coollab.AppImage");
+    CHECK((*releases)[0].changelog_url == "https://github.com/Coollab-Art/Coollab/blob/1.2.0/changelog.md");
+    CHECK(!(*releases)[0].sha256.has_value());
+    CHECK(!(*releases)[0].zsync_url.has_value());
+    CHECK((*releases)[1].name.as_string_raw() == "1.1.0 MacOS");
+    CHECK((*releases)[1].download_url == "https://example.com/1.1.0/Coollab.AppImage");
+    CHECK((*releases)[1].sha256 == "abcdef");
+    CHECK((*releases)[1].zsync_url == "https://example.com/1.1.0/Coollab.AppImage.zsync");
+
+    CHECK(!parse_releases(R"json([{"name": "1.2.0",)json", "Coollab.AppImage", []() { return false; }).has_value());
+    CHECK(!parse_releases(json, "Coollab.AppImage", []() { return true; }).has_value());
+}
+#endif
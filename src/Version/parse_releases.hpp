@@ -0,0 +1,9 @@
+#pragma once
+#include <tl/expected.hpp>
+#include "ReleaseCatalog.hpp"
+
+/// Extracts the releases that have an asset named `asset_name` from the answer of Github's releases API. The result is sorted from latest to oldest version.
+/// The json is streamed through instead of being fully built, because it is big (it contains the description of each release, who uploaded each of their assets, etc.) and we only need a few fields of it.
+/// Returns an error if the json is invalid, or if `wants_to_cancel()` returned true.
+auto parse_releases(std::string_view json, std::string const& asset_name, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<std::vector<ReleaseCatalog::Release>, std::string>;
@@ -1,6 +1,5 @@
 #include "Task_FetchCompatibilityFile.hpp"
 #include <sstream>
-#include "Cool/File/File.h"
 #include "Cool/Task/TaskManager.hpp"
 #include "Cool/Utils/getline.hpp"
 #include "Path.hpp"
@@ -10,15 +9,18 @@
 
 auto Task_FetchCompatibilityFile::execute() -> Cool::TaskCoroutine
 {
-    auto const res = make_http_request("https://raw.githubusercontent.com/Coollab-Art/Coollab/refs/heads/main/versions_compatibility.txt", [&](uint64_t, uint64_t) {
+    // On a 200, the new file is written to disk by make_conditional_http_request()
+    auto const res = make_conditional_http_request("https://raw.githubusercontent.com/Coollab-Art/Coollab/refs/heads/main/versions_compatibility.txt", Path::versions_compatibility_file(), [&](uint64_t, uint64_t) {
         return !has_been_canceled();
     });
 
-    if (!res || res->status != 200)
+    if (!res || (res->status != 200 && res->status != 304))
     {
         handle_error(res);
         co_return;
     }
+    if (res->status == 304) // The file hasn't changed since we last downloaded it, and we already loaded it from disk when constructing VersionCompatibility
+        co_return;
 
     auto compatibility_entries = std::vector<CompatibilityEntry>{};
     auto string_stream         = std::stringstream{res->body};
@@ -26,8 +28,6 @@ auto Task_FetchCompatibilityFile::execute() -> Cool::TaskCoroutine
     while (Cool::getline(string_stream, line))
         parse_compatibility_file_line(line, compatibility_entries);
     version_compatibility().set_compatibility_entries(std::move(compatibility_entries));
-
-    Cool::File::set_content(Path::versions_compatibility_file(), res->body);
 }
 
 void Task_FetchCompatibilityFile::handle_error(httplib::Result const& res)
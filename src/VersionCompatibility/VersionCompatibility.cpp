@@ -10,104 +10,267 @@
 #include "parse_compatibility_file_line.hpp"
 #include "range/v3/view.hpp"
 
-VersionCompatibility::VersionCompatibility()
-{
-    auto ifs = std::ifstream{Path::versions_compatibility_file()};
-    if (ifs.is_open())
-    {
-        auto line = std::string{};
-        while (Cool::getline(ifs, line))
-            parse_compatibility_file_line(line, _compatibility_entries);
-    }
-
-    Cool::task_manager().submit(std::make_shared<Task_FetchCompatibilityFile>()); // It's simpler to submit the task after parsing the file, it avoids concurrency if the fetch finishes before we finished parsing the file here
-}
-
-auto VersionCompatibility::compatible_versions(VersionName const& version_name) const -> std::vector<VersionNameAndUpgradeInstructions>
+/// `versions_generation` and `show_experimental_versions` are what `is_available` depends on, so that we know when the index needs to be rebuilt
+static auto make_compatibility_index(std::vector<CompatibilityEntry> const& entries, std::function<bool(VersionName const&)> const& is_available, uint64_t versions_generation, bool show_experimental_versions) -> CompatibilityIndex
 {
-    std::unique_lock lock{_mutex};
+    auto res                       = CompatibilityIndex{};
+    res.versions_generation        = versions_generation;
+    res.show_experimental_versions = show_experimental_versions;
+    res.segments.emplace_back();
 
-    auto res                  = std::vector<VersionNameAndUpgradeInstructions>{};
-    auto upgrade_instructions = std::vector<std::string>{};
+    // The versions since the last SemiIncompatibility or Incompatibility, from oldest to latest: they can be upgraded automatically to the latest available one among them
+    struct PendingVersion {
+        VersionName                   name;
+        bool                          is_available;
+        CompatibilityIndex::Position* position; // nullptr if the version has already been seen before (only its first occurrence counts)
+    };
+    auto pending_versions           = std::vector<PendingVersion>{};
+    auto resolve_automatic_upgrades = [&]() {
+        auto latest_available_version = VersionToUpgradeTo{DontUpgrade{}};
+        for (auto const& version : pending_versions | ranges::views::reverse)
+        {
+            if (version.position)
+                version.position->upgrade_automatically_to = latest_available_version;
+            if (version.is_available)
+                latest_available_version = version.name;
+        }
+        pending_versions.clear();
+    };
 
-    bool found{false};
-    for (auto const& entry : _compatibility_entries | ranges::views::reverse)
+    for (auto const& entry : entries | ranges::views::reverse) // The file lists the versions from latest to oldest
     {
-        bool do_break{false};
+        auto& segment = res.segments.back();
         std::visit(
             Cool::overloaded{
                 [&](VersionName const& ver) {
-                    if (found)
-                    {
-                        if (version_manager().find(ver, true /*filter_experimental_versions*/) != nullptr)
-                            res.emplace_back(VersionNameAndUpgradeInstructions{ver, upgrade_instructions});
-                    }
-                    else
+                    auto const available                 = is_available(ver);
+                    auto const [it, is_first_occurrence] = res.positions.emplace(ver, CompatibilityIndex::Position{
+                                                                                          .segment                = res.segments.size() - 1,
+                                                                                          .first_newer_version    = segment.available_versions.size() + (available ? 1 : 0), // Skip the version itself
+                                                                                          .nb_instructions_before = segment.upgrade_instructions.size(),
+                                                                                      });
+                    pending_versions.push_back({ver, available, is_first_occurrence ? &it->second : nullptr}); // Pointers to the elements of a std::map are never invalidated
+                    if (available)
                     {
-                        if (ver == version_name)
-                            found = true;
+                        segment.available_versions.push_back(ver);
+                        segment.nb_instructions_before.push_back(segment.upgrade_instructions.size());
                     }
                 },
                 [&](SemiIncompatibility const& semi_incompatibility) {
-                    if (found)
-                        upgrade_instructions.push_back(semi_incompatibility.upgrade_instruction);
+                    resolve_automatic_upgrades();
+                    segment.upgrade_instructions.push_back(semi_incompatibility.upgrade_instruction);
                 },
                 [&](Incompatibility) {
-                    if (found)
-                        do_break = true;
+                    resolve_automatic_upgrades();
+                    res.segments.emplace_back();
                 },
             },
             entry
         );
-
-        if (do_break)
-            break;
     }
-
+    resolve_automatic_upgrades();
     return res;
 }
 
-auto VersionCompatibility::version_to_upgrade_to_automatically(VersionName const& version_name) const -> VersionToUpgradeTo
+/// The generation must be read before calling this function, so that if the versions change while we build the index, it will be rebuilt at the next query
+static auto make_compatibility_index(std::vector<CompatibilityEntry> const& entries, uint64_t versions_generation, bool show_experimental_versions) -> CompatibilityIndex
 {
-    std::unique_lock lock{_mutex};
+    return make_compatibility_index(
+        entries,
+        [](VersionName const& ver) {
+            return version_manager().find(ver, true /*filter_experimental_versions*/) != nullptr;
+        },
+        versions_generation, show_experimental_versions
+    );
+}
 
-    auto res = VersionToUpgradeTo{DontUpgrade{}};
+static auto is_outdated(CompatibilityIndex const& index, uint64_t versions_generation, bool show_experimental_versions) -> bool
+{
+    return index.versions_generation != versions_generation
+           || index.show_experimental_versions != show_experimental_versions;
+}
+
+static auto compatible_versions(CompatibilityIndex const& index, VersionName const& version_name) -> std::vector<VersionNameAndUpgradeInstructions>
+{
+    auto const it = index.positions.find(version_name);
+    if (it == index.positions.end())
+        return {};
+    auto const& position = it->second;
+    auto const& segment  = index.segments[position.segment];
 
-    bool found{false};
-    for (auto const& entry : _compatibility_entries | ranges::views::reverse)
+    auto res = std::vector<VersionNameAndUpgradeInstructions>{};
+    for (size_t i = position.first_newer_version; i < segment.available_versions.size(); ++i)
     {
-        bool do_break{false};
-        std::visit(
-            Cool::overloaded{
-                [&](VersionName const& ver) {
-                    if (found)
-                    {
-                        if (version_manager().find(ver, true /*filter_experimental_versions*/) != nullptr)
-                        {
-                            res = ver;
-                        }
-                    }
-                    else
-                    {
-                        if (ver == version_name)
-                            found = true;
-                    }
-                },
-                [&](SemiIncompatibility const&) {
-                    if (found)
-                        do_break = true;
-                },
-                [&](Incompatibility) {
-                    if (found)
-                        do_break = true;
-                },
+        res.push_back(VersionNameAndUpgradeInstructions{
+            .name                 = segment.available_versions[i],
+            .upgrade_instructions = std::vector<std::string>{
+                segment.upgrade_instructions.begin() + static_cast<std::ptrdiff_t>(position.nb_instructions_before),
+                segment.upgrade_instructions.begin() + static_cast<std::ptrdiff_t>(segment.nb_instructions_before[i]),
             },
-            entry
-        );
+        });
+    }
+    return res;
+}
 
-        if (do_break)
-            break;
+static auto version_to_upgrade_to_automatically(CompatibilityIndex const& index, VersionName const& version_name) -> VersionToUpgradeTo
+{
+    auto const it = index.positions.find(version_name);
+    if (it == index.positions.end())
+        return DontUpgrade{};
+    return it->second.upgrade_automatically_to;
+}
+
+VersionCompatibility::VersionCompatibility()
+{
+    auto ifs     = std::ifstream{Path::versions_compatibility_file()};
+    auto entries = std::vector<CompatibilityEntry>{};
+    if (ifs.is_open())
+    {
+        auto line = std::string{};
+        while (Cool::getline(ifs, line))
+            parse_compatibility_file_line(line, entries);
     }
+    set_compatibility_entries(std::move(entries));
 
-    return res;
-}
\ No newline at end of file
+    Cool::task_manager().submit(std::make_shared<Task_FetchCompatibilityFile>()); // It's simpler to submit the task after parsing the file, it avoids concurrency if the fetch finishes before we finished parsing the file here
+}
+
+void VersionCompatibility::set_compatibility_entries(std::vector<CompatibilityEntry>&& entries)
+{
+    auto index = make_compatibility_index(entries, version_manager().generation(), launcher_settings().show_experimental_versions); // Before modifying, so that the other writers don't wait for it
+    _data.modify([&](CompatibilityData& data) {
+        data.entries = std::move(entries);
+        data.index   = std::move(index);
+    });
+    _generation++; // After publishing the new entries, so that nothing cached with the new generation can have been computed from the old entries
+}
+
+auto VersionCompatibility::index() const -> std::shared_ptr<CompatibilityIndex const>
+{
+    auto const versions_generation        = version_manager().generation();
+    auto const show_experimental_versions = launcher_settings().show_experimental_versions;
+    auto       data                       = _data.snapshot();
+    if (is_outdated(data->index, versions_generation, show_experimental_versions))
+    {
+        _data.modify([&](CompatibilityData& current_data) {
+            if (is_outdated(current_data.index, versions_generation, show_experimental_versions)) // Another reader might have rebuilt it in the meantime
+                current_data.index = make_compatibility_index(current_data.entries, versions_generation, show_experimental_versions);
+        });
+        data = _data.snapshot();
+    }
+    return {data, &data->index}; // Keeps the whole snapshot alive
+}
+
+auto VersionCompatibility::compatible_versions(VersionName const& version_name) const -> std::vector<VersionNameAndUpgradeInstructions>
+{
+    return ::compatible_versions(*index(), version_name);
+}
+
+auto VersionCompatibility::version_to_upgrade_to_automatically(VersionName const& version_name) const -> VersionToUpgradeTo
+{
+    return ::version_to_upgrade_to_automatically(*index(), version_name);
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include <thread>
+#include "doctest/doctest.h"
+
+TEST_CASE("Compatibility index")
+{
+    auto entries = std::vector<CompatibilityEntry>{};
+    for (auto const* line : {"1.4.0", "1.3.1", "---Rename your \"Feedback\" nodes", "1.3.0", "1.2.1", "1.2.0", "---", "1.1.0", "1.0.0"}) // From latest to oldest, like in the file
+        parse_compatibility_file_line(line, entries);
+    auto const version = [](std::string const& name) {
+        return *VersionName::from(name);
+    };
+    auto const index = make_compatibility_index(
+        entries,
+        [&](VersionName const& ver) {
+            return ver != version("1.2.1"); // e.g. it has been removed from the releases
+        },
+        0, false
+    );
+
+    CHECK(version_to_upgrade_to_automatically(index, version("1.0.0")) == VersionToUpgradeTo{version("1.1.0")});
+    CHECK(version_to_upgrade_to_automatically(index, version("1.1.0")) == VersionToUpgradeTo{DontUpgrade{}});
+    CHECK(version_to_upgrade_to_automatically(index, version("1.2.0")) == VersionToUpgradeTo{version("1.3.0")});
+    CHECK(version_to_upgrade_to_automatically(index, version("1.2.1")) == VersionToUpgradeTo{version("1.3.0")});
+    CHECK(version_to_upgrade_to_automatically(index, version("1.3.0")) == VersionToUpgradeTo{DontUpgrade{}}); // Would need some manual changes
+    CHECK(version_to_upgrade_to_automatically(index, version("1.3.1")) == VersionToUpgradeTo{version("1.4.0")});
+    CHECK(version_to_upgrade_to_automatically(index, version("0.9.0")) == VersionToUpgradeTo{DontUpgrade{}}); // Not in the file
+
+    auto const compatible = compatible_versions(index, version("1.2.0"));
+    REQUIRE(compatible.size() == 3);
+    CHECK(compatible[0].name == version("1.3.0"));
+    CHECK(compatible[0].upgrade_instructions.empty());
+    CHECK(compatible[1].name == version("1.3.1"));
+    CHECK(compatible[1].upgrade_instructions == std::vector<std::string>{"Rename your \"Feedback\" nodes"});
+    CHECK(compatible[2].name == version("1.4.0"));
+    CHECK(compatible[2].upgrade_instructions == std::vector<std::string>{"Rename your \"Feedback\" nodes"});
+    CHECK(compatible_versions(index, version("1.3.1")).size() == 1);
+    CHECK(compatible_versions(index, version("1.3.1"))[0].upgrade_instructions.empty());
+    CHECK(compatible_versions(index, version("1.0.0")).size() == 1);
+    CHECK(compatible_versions(index, version("1.4.0")).empty());
+    CHECK(compatible_versions(index, version("0.9.0")).empty());
+}
+
+TEST_CASE("The compatibility index is rebuilt when the experimental versions are shown or hidden")
+{
+    auto const index = make_compatibility_index({}, [](VersionName const&) { return true; }, 3, false);
+    CHECK(!is_outdated(index, 3, false));
+    CHECK(is_outdated(index, 3, true));
+    CHECK(is_outdated(index, 4, false));
+}
+
+TEST_CASE("Benchmark: resolving the upgrades of 1000 projects each frame, while new compatibility files get published" * doctest::skip()) // Run it with --no-skip
+{
+    static constexpr int nb_projects = 1000;
+    static constexpr int nb_frames   = 1000;
+
+    auto entries = std::vector<CompatibilityEntry>{};
+    for (int i = 299; i >= 0; --i) // From latest to oldest, like in the file
+    {
+        parse_compatibility_file_line(fmt::format("{}.{}.{}", i / 100, (i / 10) % 10, i % 10), entries);
+        if (i % 20 == 0)
+            parse_compatibility_file_line("---", entries);
+        else if (i % 7 == 0)
+            parse_compatibility_file_line("---Some upgrade instruction", entries);
+    }
+    auto projects = std::vector<VersionName>{};
+    for (int i = 0; i < nb_projects; ++i)
+        projects.push_back(*VersionName::from(fmt::format("{}.{}.{}", (i % 300) / 100, (i / 10) % 10, i % 10)));
+    auto const make_data = [&]() {
+        return CompatibilityData{entries, make_compatibility_index(entries, [](VersionName const&) { return true; }, 0, false)};
+    };
+
+    auto data      = CopyOnWrite<CompatibilityData>{make_data()};
+    auto is_done   = std::atomic<bool>{false};
+    auto publisher = std::thread{[&]() { // Like Task_FetchCompatibilityFile
+        while (!is_done.load())
+        {
+            auto new_data = make_data();
+            data.modify([&](CompatibilityData& current_data) { current_data = std::move(new_data); });
+        }
+    }};
+
+    auto nb_upgrades      = 0;
+    auto total_duration   = std::chrono::nanoseconds{};
+    auto longest_duration = std::chrono::nanoseconds{};
+    for (int frame = 0; frame < nb_frames; ++frame)
+    {
+        auto const begin = std::chrono::steady_clock::now();
+        for (auto const& project : projects)
+        {
+            auto const snapshot = data.snapshot(); // Like each call to VersionCompatibility::version_to_upgrade_to_automatically()
+            if (std::holds_alternative<VersionName>(version_to_upgrade_to_automatically(snapshot->index, project)))
+                nb_upgrades++;
+        }
+        auto const duration = std::chrono::steady_clock::now() - begin;
+        total_duration += duration;
+        longest_duration = std::max(longest_duration, std::chrono::duration_cast<std::chrono::nanoseconds>(duration));
+    }
+    is_done.store(true);
+    publisher.join();
+    MESSAGE(fmt::format("Frame: {} us on average, {} us at worst ({} upgrades)", total_duration.count() / nb_frames / 1000, longest_duration.count() / 1000, nb_upgrades));
+}
+#endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
-#include <mutex>
+#include <map>
+#include "CopyOnWrite/CopyOnWrite.hpp"
 #include "Version/VersionToUpgradeTo.hpp"
 #include "parse_compatibility_file_line.hpp"
 
@@ -8,23 +9,52 @@ struct VersionNameAndUpgradeInstructions {
     std::vector<std::string> upgrade_instructions;
 };
 
+/// Precomputed from the compatibility entries, so that the queries don't have to walk through all of them
+struct CompatibilityIndex {
+    /// Versions that are not separated by an Incompatibility
+    struct Segment {
+        std::vector<VersionName> available_versions{};     // From oldest to latest. Only the ones that can be installed
+        std::vector<size_t>      nb_instructions_before{}; // For each of the available_versions, the number of upgrade_instructions that come before it
+        std::vector<std::string> upgrade_instructions{};   // From oldest to latest
+    };
+    struct Position {
+        size_t             segment{};
+        size_t             first_newer_version{};    // Index in the segment's available_versions
+        size_t             nb_instructions_before{}; // Index in the segment's upgrade_instructions
+        VersionToUpgradeTo upgrade_automatically_to{DontUpgrade{}};
+    };
+
+    std::vector<Segment>            segments{};
+    std::map<VersionName, Position> positions{};
+    uint64_t                        versions_generation{};        // The version_manager().generation() the index has been built with, because it depends on which versions are available
+    bool                            show_experimental_versions{}; // The launcher_settings().show_experimental_versions the index has been built with, because it changes which versions are available
+};
+
+struct CompatibilityData {
+    std::vector<CompatibilityEntry> entries{};
+    CompatibilityIndex              index{};
+};
+
+/// Can be used from any thread. Readers work on an immutable snapshot, so they never wait for a new compatibility file to be parsed
 class VersionCompatibility {
 public:
     VersionCompatibility();
     auto compatible_versions(VersionName const&) const -> std::vector<VersionNameAndUpgradeInstructions>;
     auto version_to_upgrade_to_automatically(VersionName const&) const -> VersionToUpgradeTo;
+    /// Changes each time we get a new compatibility file, so that you can cache things that depend on it.
+    /// The answers also depend on which versions exist, so you need to check version_manager().generation() too.
+    auto generation() const -> uint64_t { return _generation.load(); }
 
 private:
     friend class Task_FetchCompatibilityFile;
-    void set_compatibility_entries(std::vector<CompatibilityEntry>&& entries)
-    {
-        std::unique_lock lock{_mutex};
-        _compatibility_entries = std::move(entries);
-    }
+    void set_compatibility_entries(std::vector<CompatibilityEntry>&& entries);
+
+    /// Rebuilds the index if the list of versions (or the setting that filters them) has changed since we built it
+    auto index() const -> std::shared_ptr<CompatibilityIndex const>;
 
 private:
-    std::vector<CompatibilityEntry> _compatibility_entries;
-    mutable std::mutex              _mutex;
+    mutable CopyOnWrite<CompatibilityData> _data{}; // Read every frame by the UI, and replaced when we fetch a new compatibility file
+    std::atomic<uint64_t>                  _generation{0};
 };
 
 inline auto version_compatibility() -> VersionCompatibility&
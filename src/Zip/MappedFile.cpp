@@ -0,0 +1,72 @@
+#include "MappedFile.hpp"
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(std::filesystem::path const& path)
+{
+    _file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE) // NOLINT(*pro-type-cstyle-cast, *performance-no-int-to-ptr)
+    {
+        _file = nullptr;
+        return;
+    }
+    auto size = LARGE_INTEGER{};
+    if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) // A file of size 0 can't be mapped
+        return;
+    _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!_mapping)
+        return;
+    _data = static_cast<char const*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    _size = _data ? static_cast<size_t>(size.QuadPart) : 0;
+}
+
+MappedFile::~MappedFile()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    if (_file)
+        CloseHandle(_file);
+}
+
+#else
+
+MappedFile::MappedFile(std::filesystem::path const& path)
+{
+    _file = open(path.c_str(), O_RDONLY); // NOLINT(*vararg)
+    if (_file == -1)
+        return;
+    struct stat info{};
+    if (fstat(_file, &info) != 0 || info.st_size == 0) // A file of size 0 can't be mapped
+        return;
+    void* const data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+    if (data == MAP_FAILED) // NOLINT(*pro-type-cstyle-cast, *performance-no-int-to-ptr)
+        return;
+    _data = static_cast<char const*>(data);
+    _size = static_cast<size_t>(info.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+    if (_data)
+        munmap(const_cast<char*>(_data), _size); // NOLINT(*const-cast)
+    if (_file != -1)
+        close(_file);
+}
+
+#endif
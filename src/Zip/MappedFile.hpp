@@ -0,0 +1,28 @@
+#pragma once
+
+/// Read-only view of a whole file, mapped in memory by the OS.
+/// Several threads can read from it at the same time, without each of them having to open and read the file.
+class MappedFile {
+public:
+    /// Check is_open() to know if it succeeded
+    explicit MappedFile(std::filesystem::path const& path);
+    ~MappedFile();
+    MappedFile(MappedFile const&)                = delete;
+    MappedFile& operator=(MappedFile const&)     = delete;
+    MappedFile(MappedFile&&) noexcept            = delete;
+    MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+    auto is_open() const -> bool { return _data != nullptr; }
+    auto data() const -> char const* { return _data; }
+    auto size() const -> size_t { return _size; }
+
+private:
+    char const* _data{nullptr};
+    size_t      _size{0};
+#if defined(_WIN32)
+    void* _file{nullptr};
+    void* _mapping{nullptr};
+#else
+    int _file{-1};
+#endif
+};
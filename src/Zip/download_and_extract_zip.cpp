@@ -0,0 +1,408 @@
+#include "download_and_extract_zip.hpp"
+#include <condition_variable>
+#include <fstream>
+#include <future>
+#include "Cool/File/File.h"
+#include "Download/download_file.hpp"
+#include "extract_zip.hpp"
+#include "mz.h"
+#include "mz_crypt.h"
+#include "mz_strm.h"
+#include "mz_strm_mem.h"
+#include "mz_strm_zlib.h"
+
+/// Number of bytes at the beginning of the zip that have been downloaded and can be read
+class BytesAvailable {
+public:
+    void set(uint64_t nb_bytes)
+    {
+        {
+            auto lock = std::unique_lock{_mutex};
+            if (nb_bytes < _nb_bytes)
+                _has_been_rewritten = true; // The download had to restart from scratch
+            _nb_bytes = nb_bytes;
+        }
+        _condition.notify_all();
+    }
+
+    /// No more bytes will come, either because the download is over or because it has been cancelled
+    void set_finished()
+    {
+        {
+            auto lock    = std::unique_lock{_mutex};
+            _is_finished = true;
+        }
+        _condition.notify_all();
+    }
+
+    /// Blocks until the first `nb_bytes` of the file are available. Returns false if this will never happen.
+    auto wait_for(uint64_t nb_bytes) -> bool
+    {
+        auto lock = std::unique_lock{_mutex};
+        _condition.wait(lock, [&]() { return _nb_bytes >= nb_bytes || _is_finished || _has_been_rewritten; });
+        return _nb_bytes >= nb_bytes && !_has_been_rewritten;
+    }
+
+    auto has_been_rewritten() -> bool
+    {
+        auto lock = std::unique_lock{_mutex};
+        return _has_been_rewritten;
+    }
+
+private:
+    std::mutex              _mutex{};
+    std::condition_variable _condition{};
+    uint64_t                _nb_bytes{0};
+    bool                    _is_finished{false};
+    bool                    _has_been_rewritten{false};
+};
+
+/// Reads a file while it is being downloaded, waiting for the bytes we ask for to arrive
+class GrowingFileReader {
+public:
+    GrowingFileReader(std::filesystem::path path, BytesAvailable& bytes_available)
+        : _path{std::move(path)}
+        , _bytes_available{bytes_available}
+    {}
+
+    /// Returns false if these bytes will never be available
+    auto read(uint64_t offset, char* data, size_t size) -> bool
+    {
+        if (!_bytes_available.wait_for(offset + size))
+            return false;
+        if (!_file.is_open())
+            _file.open(_path, std::ios::binary); // We can only open it once the download has started creating it
+        _file.clear(); // We might have reached the end of the file during a previous read, but it has grown since then
+        _file.seekg(static_cast<std::streamoff>(offset));
+        _file.read(data, static_cast<std::streamsize>(size));
+        return !_file.fail();
+    }
+
+private:
+    std::filesystem::path _path;
+    std::ifstream         _file{};
+    BytesAvailable&       _bytes_available; // NOLINT(*avoid-const-or-ref-data-members)
+};
+
+static auto read_u16(char const* data) -> uint16_t
+{
+    auto const* const bytes = reinterpret_cast<uint8_t const*>(data); // NOLINT(*reinterpret-cast)
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));         // NOLINT(*pointer-arithmetic)
+}
+
+static auto read_u32(char const* data) -> uint32_t
+{
+    return static_cast<uint32_t>(read_u16(data)) | (static_cast<uint32_t>(read_u16(data + 2)) << 16); // NOLINT(*pointer-arithmetic)
+}
+
+static auto read_u64(char const* data) -> uint64_t
+{
+    return static_cast<uint64_t>(read_u32(data)) | (static_cast<uint64_t>(read_u32(data + 4)) << 32); // NOLINT(*pointer-arithmetic)
+}
+
+static constexpr uint16_t compression_method_stored{0};
+static constexpr uint16_t compression_method_deflate{8};
+
+struct LocalFileHeader {
+    std::string name{};
+    uint16_t    compression_method{};
+    uint32_t    crc{};
+    uint64_t    compressed_size{};
+    uint64_t    uncompressed_size{};
+    uint64_t    data_offset{}; // Position of the entry's data in the zip, right after its header
+};
+
+/// We only extract ahead of time the entries whose name is plain and safe, the other ones are left to minizip
+static auto is_simple_entry_name(std::string const& name) -> bool
+{
+    if (name.empty())
+        return false;
+    if (std::any_of(name.begin(), name.end(), [](char c) { return static_cast<unsigned char>(c) >= 0x80 || c == '\\' || c == ':'; })) // The encoding of non-ascii names depends on flags, and we don't want to deal with drive letters or Windows separators
+        return false;
+    auto const path = std::filesystem::path{name};
+    if (path.has_root_path())
+        return false;
+    return std::none_of(path.begin(), path.end(), [](std::filesystem::path const& part) { return part == ".."; });
+}
+
+/// Returns nullopt if there is no local file header at `offset` (e.g. because we reached the central directory at the end of the zip), or if it describes an entry that we can't extract before knowing the central directory
+static auto read_local_file_header(GrowingFileReader& reader, uint64_t offset) -> std::optional<LocalFileHeader>
+{
+    static constexpr uint32_t signature{0x04034b50};
+    static constexpr uint16_t flag_encrypted{1 << 0};
+    static constexpr uint16_t flag_data_descriptor{1 << 3}; // The sizes and CRC are written after the data, so we can't know where the entry ends
+    static constexpr uint32_t zip64_marker{0xFFFFFFFF};
+    static constexpr uint16_t zip64_extra_field_id{0x0001};
+
+    auto header = std::array<char, 30>{};
+    if (!reader.read(offset, header.data(), header.size()))
+        return std::nullopt;
+    if (read_u32(&header[0]) != signature)
+        return std::nullopt;
+
+    auto const flags = read_u16(&header[6]);
+    if (flags & (flag_encrypted | flag_data_descriptor))
+        return std::nullopt;
+
+    auto entry = LocalFileHeader{
+        .compression_method = read_u16(&header[8]),
+        .crc                = read_u32(&header[14]),
+        .compressed_size    = read_u32(&header[18]),
+        .uncompressed_size  = read_u32(&header[22]),
+    };
+    if (entry.compression_method != compression_method_stored && entry.compression_method != compression_method_deflate)
+        return std::nullopt;
+
+    auto const name_length  = read_u16(&header[26]);
+    auto const extra_length = read_u16(&header[28]);
+    auto       name_extra   = std::string(static_cast<size_t>(name_length) + extra_length, '\0');
+    if (!reader.read(offset + header.size(), name_extra.data(), name_extra.size()))
+        return std::nullopt;
+    entry.name        = name_extra.substr(0, name_length);
+    entry.data_offset = offset + header.size() + name_extra.size();
+    if (!is_simple_entry_name(entry.name))
+        return std::nullopt;
+
+    if (entry.compressed_size == zip64_marker || entry.uncompressed_size == zip64_marker)
+    {
+        // The actual sizes are stored in the zip64 extra field
+        auto is_zip64 = false;
+        for (size_t i = name_length; i + 4 <= name_extra.size();)
+        {
+            auto const id   = read_u16(&name_extra[i]);
+            auto const size = read_u16(&name_extra[i + 2]);
+            if (id == zip64_extra_field_id && i + 4 + 16 <= name_extra.size() && size >= 16)
+            {
+                entry.uncompressed_size = read_u64(&name_extra[i + 4]);
+                entry.compressed_size   = read_u64(&name_extra[i + 12]);
+                is_zip64                = true;
+                break;
+            }
+            i += 4 + size;
+        }
+        if (!is_zip64)
+            return std::nullopt;
+    }
+    if (entry.compression_method == compression_method_stored && entry.compressed_size != entry.uncompressed_size)
+        return std::nullopt;
+
+    return entry;
+}
+
+using WriteCallback = std::function<bool(char const* data, size_t size)>;
+
+static auto copy_stored_entry(GrowingFileReader& reader, LocalFileHeader const& entry, WriteCallback const& write) -> bool
+{
+    static constexpr uint64_t chunk_size{1'000'000}; // Big entries are copied chunk by chunk, as soon as each chunk is downloaded
+
+    auto buffer = std::vector<char>(static_cast<size_t>(std::min(chunk_size, entry.compressed_size)));
+    for (uint64_t position = 0; position < entry.compressed_size; position += chunk_size)
+    {
+        auto const size = static_cast<size_t>(std::min(chunk_size, entry.compressed_size - position));
+        if (!reader.read(entry.data_offset + position, buffer.data(), size))
+            return false;
+        if (!write(buffer.data(), size))
+            return false;
+    }
+    return true;
+}
+
+static auto inflate_entry(GrowingFileReader& reader, LocalFileHeader const& entry, WriteCallback const& write) -> bool
+{
+    if (entry.compressed_size > static_cast<uint64_t>(std::numeric_limits<int32_t>::max()))
+        return false; // minizip's memory stream can't handle it
+
+    auto compressed = std::vector<char>(static_cast<size_t>(entry.compressed_size));
+    if (!reader.read(entry.data_offset, compressed.data(), compressed.size()))
+        return false;
+
+    void* stream_mem = mz_stream_mem_create();
+    if (!stream_mem)
+        return false;
+    auto const scope_guard = sg::make_scope_guard([&] { mz_stream_mem_delete(&stream_mem); });
+    mz_stream_mem_set_buffer(stream_mem, compressed.data(), static_cast<int32_t>(compressed.size()));
+    if (mz_stream_mem_seek(stream_mem, 0, MZ_SEEK_SET) != MZ_OK)
+        return false;
+
+    void* stream_zlib = mz_stream_zlib_create();
+    if (!stream_zlib)
+        return false;
+    auto const scope_guard2 = sg::make_scope_guard([&] { mz_stream_zlib_delete(&stream_zlib); });
+    mz_stream_set_base(stream_zlib, stream_mem);
+    mz_stream_set_prop_int64(stream_zlib, MZ_STREAM_PROP_TOTAL_IN_MAX, static_cast<int64_t>(entry.compressed_size));
+    if (mz_stream_open(stream_zlib, nullptr, MZ_OPEN_MODE_READ) != MZ_OK)
+        return false;
+    auto const scope_guard3 = sg::make_scope_guard([&] { mz_stream_close(stream_zlib); });
+
+    auto buffer         = std::vector<char>(256'000);
+    auto total_inflated = uint64_t{0};
+    while (true)
+    {
+        auto const size = mz_stream_read(stream_zlib, buffer.data(), static_cast<int32_t>(buffer.size()));
+        if (size < 0)
+            return false;
+        if (size == 0)
+            break;
+        if (!write(buffer.data(), static_cast<size_t>(size)))
+            return false;
+        total_inflated += static_cast<uint64_t>(size);
+    }
+    return total_inflated == entry.uncompressed_size;
+}
+
+/// Returns the CRC of the extracted file, or nullopt if we couldn't extract it
+static auto extract_entry(GrowingFileReader& reader, LocalFileHeader const& entry, std::filesystem::path const& path) -> std::optional<uint32_t>
+{
+    if (!Cool::File::create_folders_for_file_if_they_dont_exist(path))
+        return std::nullopt;
+    auto file = std::ofstream{path, std::ios::binary | std::ios::trunc};
+    if (!file.is_open())
+        return std::nullopt;
+
+    auto       crc   = uint32_t{0};
+    auto const write = [&](char const* data, size_t size) {
+        crc = mz_crypt_crc32_update(crc, reinterpret_cast<uint8_t const*>(data), static_cast<int32_t>(size)); // NOLINT(*reinterpret-cast)
+        file.write(data, static_cast<std::streamsize>(size));
+        return !file.fail();
+    };
+    auto const success = entry.compression_method == compression_method_stored
+                             ? copy_stored_entry(reader, entry, write)
+                             : inflate_entry(reader, entry, write);
+    file.close();
+    if (!success || file.fail() || crc != entry.crc)
+        return std::nullopt;
+    return crc;
+}
+
+/// Walks the local file headers, in the order in which they are downloaded, and extracts each entry as soon as its data is available
+/// Stops at the central directory, or at the first entry that needs the central directory to be extracted; that entry and the following ones will be extracted once the download is over
+static auto extract_while_downloading(std::filesystem::path const& zip_path, std::filesystem::path const& destination_folder, BytesAvailable& bytes_available, std::atomic<bool> const& cancel)
+    -> AlreadyExtractedEntries
+{
+    auto extracted = AlreadyExtractedEntries{};
+    auto reader    = GrowingFileReader{zip_path, bytes_available};
+    auto offset    = uint64_t{0};
+    while (!cancel.load())
+    {
+        auto const entry = read_local_file_header(reader, offset);
+        if (!entry)
+            break;
+        offset = entry->data_offset + entry->compressed_size;
+
+        auto const path = destination_folder / entry->name;
+        if (entry->name.ends_with('/'))
+        {
+            if (!Cool::File::create_folders_if_they_dont_exist(path))
+                break;
+            continue;
+        }
+        auto const crc = extract_entry(reader, *entry, path);
+        if (!crc)
+            break;
+        extracted[entry->name] = *crc;
+    }
+    return extracted;
+}
+
+auto download_and_extract_zip(std::string const& url, std::filesystem::path const& zip_path, std::filesystem::path const& destination_folder, DownloadOptions options, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<std::string, std::string>
+{
+    auto bytes_available   = BytesAvailable{};
+    auto cancel            = std::atomic<bool>{false};
+    auto already_extracted = std::async(std::launch::async, [&]() {
+        return extract_while_downloading(zip_path, destination_folder, bytes_available, cancel);
+    });
+    auto const scope_guard = sg::make_scope_guard([&] { // Make sure the extraction thread doesn't wait forever for bytes that will never come, otherwise the destructor of the future would block
+        bytes_available.set_finished();
+    });
+
+    options.on_bytes_available = [&](uint64_t nb_bytes) {
+        bytes_available.set(nb_bytes);
+    };
+    auto const download_result = download_file(
+        url, zip_path, options,
+        [&](float progress) { set_progress(progress * 0.95f); }, // Most of the extraction happens during the download, so the remaining extraction is quick
+        [&]() {
+            if (wants_to_cancel())
+                cancel.store(true);
+            return cancel.load();
+        }
+    );
+    bytes_available.set_finished();
+    auto extracted = already_extracted.get();
+
+    if (wants_to_cancel())
+        return ""s;
+    if (!download_result.has_value())
+        return download_result;
+
+    if (bytes_available.has_been_rewritten())
+    {
+        // The download restarted from scratch, so what we extracted might not match the zip we finally got
+        extracted.clear();
+        Cool::File::remove_folder(destination_folder);
+    }
+    auto const extraction_result = extract_zip(zip_path, destination_folder, [&](float progress) { set_progress(0.95f + progress * 0.05f); }, wants_to_cancel, extracted);
+    if (!extraction_result.has_value())
+        return tl::make_unexpected(extraction_result.error());
+    return download_result;
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "Testing/LocalFileServer.hpp"
+#include "Testing/ZipBuilder.hpp"
+#include "doctest/doctest.h"
+
+static auto read_file(std::filesystem::path const& path) -> std::string
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Extracting a zip while it is downloading")
+{
+    static constexpr auto deflated = std::array<uint8_t, 35>{
+        0x73, 0x49, 0x4d, 0xcb, 0x49, 0x2c, 0x49, 0x4d, 0x51, 0x48, 0xce, 0xcf, 0x2b, 0x49, 0xcd, 0x2b, 0xd1, 0x51,
+        0x48, 0x21, 0x28, 0xa2, 0xc8, 0xe5, 0x32, 0xaa, 0x6b, 0x54, 0xd7, 0xa8, 0xae, 0x11, 0xac, 0x0b, 0x00
+    };
+    auto deflated_content = std::string{};
+    for (int i = 0; i < 20; ++i)
+        deflated_content += "Deflated content, deflated content, deflated content!\n";
+
+    auto zip = ZipBuilder{};
+    zip.add({.name = "Coollab/"});
+    zip.add({.name = "Coollab/first.txt", .content = "First file"});
+    for (int i = 0; i < 10; ++i)
+        zip.add({.name = fmt::format("Coollab/res/file_{}.bin", i), .content = std::string(300'000, static_cast<char>('a' + i))});
+    zip.add({.name = "Coollab/deflated.txt", .content = deflated_content, .compressed_content = std::string{deflated.begin(), deflated.end()}});
+    zip.add({.name = "Coollab/executable", .content = "#!/bin/sh", .unix_permissions = 0755});
+    zip.add({.name = "Coollab/with_data_descriptor.txt", .content = "Can only be extracted once we know the central directory", .has_data_descriptor = true});
+    zip.add({.name = "Coollab/last.txt", .content = "Last file"});
+
+    auto const server             = LocalFileServer{zip.build(), 5ms /*delay_between_chunks*/};
+    auto const folder             = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "download_and_extract_zip";
+    auto const destination_folder = folder / "Installed";
+    Cool::File::remove_folder(folder);
+
+    auto has_extracted_during_download = false;
+    auto const res = download_and_extract_zip(
+        server.url(), folder / "download.zip", destination_folder, DownloadOptions{},
+        [&](float progress) {
+            if (progress < 0.9f && Cool::File::exists(destination_folder / "Coollab/first.txt"))
+                has_extracted_during_download = true;
+        },
+        []() { return false; }
+    );
+    REQUIRE(res.has_value());
+    CHECK(has_extracted_during_download);
+    CHECK(read_file(destination_folder / "Coollab/first.txt") == "First file");
+    CHECK(read_file(destination_folder / "Coollab/res/file_9.bin") == std::string(300'000, 'j'));
+    CHECK(read_file(destination_folder / "Coollab/deflated.txt") == deflated_content);
+    CHECK(read_file(destination_folder / "Coollab/with_data_descriptor.txt") == "Can only be extracted once we know the central directory");
+    CHECK(read_file(destination_folder / "Coollab/last.txt") == "Last file");
+#if defined(__linux__) || defined(__APPLE__)
+    CHECK((std::filesystem::status(destination_folder / "Coollab/executable").permissions() & std::filesystem::perms::owner_exec) != std::filesystem::perms::none);
+#endif
+    Cool::File::remove_folder(folder);
+}
+#endif
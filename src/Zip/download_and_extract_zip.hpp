@@ -0,0 +1,11 @@
+#pragma once
+#include "Download/download_file.hpp"
+#include "tl/expected.hpp"
+
+/// Downloads the zip at `url` into `zip_path`, and extracts it into `destination_folder`.
+/// The extraction starts while the zip is still downloading: each entry is extracted as soon as all of its bytes have arrived, so most of the extraction time overlaps with the download.
+/// The entries that can't be extracted ahead of time (e.g. because their size is only written after their data) are extracted once the download is complete.
+/// If `wants_to_cancel()` returns true, everything stops and no error is returned.
+/// Returns the SHA-256 of the zip. `options.on_bytes_available` is ignored, because this is what we use to extract while downloading.
+auto download_and_extract_zip(std::string const& url, std::filesystem::path const& zip_path, std::filesystem::path const& destination_folder, DownloadOptions options, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel)
+    -> tl::expected<std::string, std::string>;
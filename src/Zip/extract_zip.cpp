@@ -0,0 +1,333 @@
+#include "extract_zip.hpp"
+#include <future>
+#include <set>
+#include "Cool/File/File.h"
+#include "MappedFile.hpp"
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_mem.h"
+#include "mz_zip.h"
+#include "mz_zip_rw.h"
+
+auto minizip_error_string(int32_t code) -> std::string
+{
+    switch (code)
+    {
+    case MZ_OK: return "Success";
+    case MZ_MEM_ERROR: return "Memory error";
+    case MZ_PARAM_ERROR: return "Invalid parameter";
+    case MZ_FORMAT_ERROR: return "ZIP format error";
+    case MZ_EXIST_ERROR: return "File already exists";
+    case MZ_OPEN_ERROR: return "Cannot open file";
+    case MZ_CLOSE_ERROR: return "Cannot close file";
+    case MZ_READ_ERROR: return "Read error";
+    case MZ_WRITE_ERROR: return "Write error";
+    case MZ_CRC_ERROR: return "CRC mismatch";
+    default: return fmt::format("Unknown error ({})", code);
+    }
+}
+
+static auto file_error(std::filesystem::path const& destination_folder) -> tl::unexpected<std::string>
+{
+    return tl::make_unexpected(fmt::format("Make sure you have the permission to write files in the folder \"{}\"", destination_folder.parent_path()));
+}
+
+static auto zip_error(std::string const& debug_error_message) -> tl::unexpected<std::string>
+{
+    Cool::Log::internal_warning("Unzip version", debug_error_message);
+    return tl::make_unexpected("An unexpected error has occurred, please try again"s);
+}
+
+/// Each thread needs its own reader, because a reader can only be positioned on one entry at a time
+class ZipReader {
+public:
+    ZipReader() = default;
+    ~ZipReader()
+    {
+        if (_reader)
+        {
+            mz_zip_reader_close(_reader);
+            mz_zip_reader_delete(&_reader);
+        }
+        if (_stream_mem)
+            mz_stream_mem_delete(&_stream_mem);
+    }
+    ZipReader(ZipReader const&)                = delete;
+    ZipReader& operator=(ZipReader const&)     = delete;
+    ZipReader(ZipReader&&) noexcept            = delete;
+    ZipReader& operator=(ZipReader&&) noexcept = delete;
+
+    /// Reads from the memory-mapped zip if possible, otherwise from the file on disk
+    auto open(std::filesystem::path const& zip_path, MappedFile const& mapped_zip) -> tl::expected<void, std::string>
+    {
+        _reader = mz_zip_reader_create();
+        if (!_reader)
+            return zip_error("Failed to initialize zip reader");
+
+        if (!mapped_zip.is_open() || mapped_zip.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) // minizip's memory stream can't handle more than 2GB
+        {
+            auto const res = mz_zip_reader_open_file(_reader, zip_path.string().c_str());
+            if (res != MZ_OK)
+                return zip_error(fmt::format("Failed to open zip file: {}", minizip_error_string(res)));
+            return {};
+        }
+
+        _stream_mem = mz_stream_mem_create();
+        if (!_stream_mem)
+            return zip_error("Failed to initialize memory stream");
+        mz_stream_mem_set_buffer(_stream_mem, const_cast<char*>(mapped_zip.data()), static_cast<int32_t>(mapped_zip.size())); // NOLINT(*const-cast)
+        {
+            auto const res = mz_stream_mem_seek(_stream_mem, 0, MZ_SEEK_SET);
+            if (res != MZ_OK)
+                return zip_error(fmt::format("Failed to seek in memory stream: {}", minizip_error_string(res)));
+        }
+        {
+            auto const res = mz_zip_reader_open(_reader, _stream_mem);
+            if (res != MZ_OK)
+                return zip_error(fmt::format("Failed to open zip: {}", minizip_error_string(res)));
+        }
+        return {};
+    }
+
+    auto handle() const -> void* { return _reader; }
+
+private:
+    void* _reader{nullptr};
+    void* _stream_mem{nullptr};
+};
+
+/// Applies the unix permissions stored in the central directory (e.g. the executable bit of the MacOS binaries)
+static void restore_permissions(std::filesystem::path const& path, mz_zip_file const& file_info)
+{
+    static constexpr uint8_t host_system_unix{3};
+    static constexpr uint8_t host_system_osx_darwin{19};
+
+    auto const host_system = static_cast<uint8_t>(file_info.version_madeby >> 8);
+    if (host_system != host_system_unix && host_system != host_system_osx_darwin)
+        return; // The zip was not made on a system that has unix permissions
+
+    auto const mode = static_cast<std::filesystem::perms>((file_info.external_fa >> 16) & 0777);
+    if (mode == std::filesystem::perms::none)
+        return;
+    auto error_code = std::error_code{};
+    std::filesystem::permissions(path, mode, error_code);
+    if (error_code)
+        Cool::Log::internal_warning("Unzip", fmt::format("Failed to set the permissions of \"{}\": {}", path, error_code.message()));
+}
+
+struct EntryToExtract {
+    size_t                index_in_zip{}; // Position of the entry in the central directory
+    std::filesystem::path path{};
+    std::string           name{};
+    uint64_t              uncompressed_size{};
+};
+
+/// Shared by all the threads
+struct ExtractionState {
+    std::atomic<size_t>   next_entry{0}; // Each thread claims the next entry when it is done with its current one, so that the work stays balanced even if some entries are much bigger than others
+    std::atomic<uint64_t> bytes_extracted{0};
+    std::atomic<bool>     stop{false};
+};
+
+/// Lists the entries that need to be extracted, and creates all the folders beforehand so that the threads don't compete to create the same folders
+static auto prepare_extraction(ZipReader const& reader, std::filesystem::path const& destination_folder, AlreadyExtractedEntries const& already_extracted)
+    -> tl::expected<std::vector<EntryToExtract>, std::string>
+{
+    auto entries = std::vector<EntryToExtract>{};
+    auto folders = std::set<std::filesystem::path>{};
+
+    size_t index = 0;
+    for (auto res = mz_zip_reader_goto_first_entry(reader.handle()); res == MZ_OK; res = mz_zip_reader_goto_next_entry(reader.handle()), ++index)
+    {
+        mz_zip_file* file_info{};
+        {
+            auto const res2 = mz_zip_reader_entry_get_info(reader.handle(), &file_info);
+            if (res2 != MZ_OK || file_info == nullptr || file_info->filename == nullptr)
+                return zip_error(fmt::format("Failed to get entry info: {}", minizip_error_string(res2)));
+        }
+
+        auto const full_path = destination_folder / file_info->filename;
+        if (mz_zip_reader_entry_is_dir(reader.handle()) == MZ_OK)
+        {
+            folders.insert(full_path);
+            continue;
+        }
+        folders.insert(full_path.parent_path());
+
+        auto const it = already_extracted.find(file_info->filename);
+        if (it != already_extracted.end())
+        {
+            if (it->second == file_info->crc && mz_zip_attrib_is_symlink(file_info->external_fa, file_info->version_madeby) != MZ_OK)
+            {
+                restore_permissions(full_path, *file_info);
+                continue;
+            }
+            Cool::File::remove_file(full_path); // It doesn't match what the central directory says, or it needs to be a symlink, so extract it again
+        }
+
+        entries.push_back(EntryToExtract{
+            .index_in_zip      = index,
+            .path              = full_path,
+            .name              = file_info->filename,
+            .uncompressed_size = static_cast<uint64_t>(file_info->uncompressed_size),
+        });
+    }
+
+    for (auto const& folder : folders)
+    {
+        if (!Cool::File::create_folders_if_they_dont_exist(folder))
+            return file_error(destination_folder);
+    }
+    return entries;
+}
+
+static auto extract_entries(std::filesystem::path const& zip_path, MappedFile const& mapped_zip, std::vector<EntryToExtract> const& entries, ExtractionState& state)
+    -> tl::expected<void, std::string>
+{
+    auto reader = ZipReader{};
+    {
+        auto const success = reader.open(zip_path, mapped_zip);
+        if (!success.has_value())
+            return success;
+    }
+
+    // The entries are claimed in increasing order, so we can just move forward in the central directory instead of looking each entry up by name
+    auto current_index = std::optional<size_t>{};
+    while (!state.stop.load())
+    {
+        auto const claimed = state.next_entry.fetch_add(1);
+        if (claimed >= entries.size())
+            break;
+        auto const& entry = entries[claimed];
+
+        while (!current_index || *current_index < entry.index_in_zip)
+        {
+            auto const res = current_index ? mz_zip_reader_goto_next_entry(reader.handle()) : mz_zip_reader_goto_first_entry(reader.handle());
+            if (res != MZ_OK)
+                return zip_error(fmt::format("Failed to go to zip entry \"{}\": {}", entry.name, minizip_error_string(res)));
+            current_index = current_index ? *current_index + 1 : 0;
+        }
+
+        {
+            auto const res = mz_zip_reader_entry_open(reader.handle());
+            if (res != MZ_OK)
+                return zip_error(fmt::format("Failed to open zip entry: {}", minizip_error_string(res)));
+        }
+        auto const scope_guard = sg::make_scope_guard([&] { mz_zip_reader_entry_close(reader.handle()); });
+
+        {
+            auto const res = mz_zip_reader_entry_save_file(reader.handle(), entry.path.string().c_str());
+            if (res != MZ_OK)
+                return zip_error(fmt::format("Failed to extract file \"{}\": {}", entry.name, minizip_error_string(res)));
+        }
+        state.bytes_extracted.fetch_add(entry.uncompressed_size);
+    }
+    return {};
+}
+
+auto extract_zip(std::filesystem::path const& zip_path, std::filesystem::path const& destination_folder, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel, AlreadyExtractedEntries const& already_extracted)
+    -> tl::expected<void, std::string>
+{
+    if (!Cool::File::create_folders_if_they_dont_exist(destination_folder))
+        return file_error(destination_folder);
+
+    auto const mapped_zip = MappedFile{zip_path}; // If it fails, we will just read the file from disk instead
+
+    auto entries = std::vector<EntryToExtract>{};
+    {
+        auto reader = ZipReader{};
+        {
+            auto const success = reader.open(zip_path, mapped_zip);
+            if (!success.has_value())
+                return success;
+        }
+        auto entries_or_error = prepare_extraction(reader, destination_folder, already_extracted);
+        if (!entries_or_error.has_value())
+            return tl::make_unexpected(entries_or_error.error());
+        entries = std::move(*entries_or_error);
+    }
+    if (entries.empty())
+        return {};
+
+    auto total_size = uint64_t{0};
+    for (auto const& entry : entries)
+        total_size += entry.uncompressed_size;
+
+    auto       state         = ExtractionState{};
+    auto const nb_threads    = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 8); // Beyond that we are limited by the disk anyways
+    auto       workers = std::vector<std::future<tl::expected<void, std::string>>>{};
+    for (size_t i = 0; i < std::min(nb_threads, entries.size()); ++i)
+    {
+        workers.push_back(std::async(std::launch::async, [&]() {
+            auto res = extract_entries(zip_path, mapped_zip, entries, state);
+            if (!res.has_value())
+                state.stop.store(true); // No need for the other threads to continue
+            return res;
+        }));
+    }
+
+    // While the threads are extracting, this thread takes care of reporting the progress and forwarding cancellation requests
+    for (auto& worker : workers)
+    {
+        while (worker.wait_for(100ms) != std::future_status::ready)
+        {
+            if (wants_to_cancel())
+                state.stop.store(true);
+            if (total_size != 0)
+                set_progress(static_cast<float>(state.bytes_extracted.load()) / static_cast<float>(total_size));
+        }
+    }
+
+    for (auto& worker : workers)
+    {
+        auto const res = worker.get();
+        if (!res.has_value())
+            return res;
+    }
+    return {}; // If we were cancelled, this is not an error
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include <fstream>
+#include "Testing/ZipBuilder.hpp"
+#include "doctest/doctest.h"
+
+static auto read_file(std::filesystem::path const& path) -> std::string
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Extracting a zip with several threads")
+{
+    static constexpr int nb_files{500};
+
+    auto zip = ZipBuilder{};
+    for (int i = 0; i < nb_files; ++i)
+        zip.add({.name = fmt::format("Coollab/res/{}/file_{}.txt", i % 7, i), .content = fmt::format("Content of file {}", i)});
+    zip.add({.name = "Coollab/big.bin", .content = std::string(3'000'000, 'x')});
+
+    auto const folder = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "extract_zip";
+    Cool::File::remove_folder(folder);
+    Cool::File::create_folders_if_they_dont_exist(folder);
+    {
+        auto file = std::ofstream{folder / "release.zip", std::ios::binary};
+        file << zip.build();
+    }
+
+    SUBCASE("All the files are extracted")
+    {
+        auto const res = extract_zip(folder / "release.zip", folder / "Installed", [](float) {}, []() { return false; });
+        REQUIRE(res.has_value());
+        for (int i = 0; i < nb_files; ++i)
+            CHECK(read_file(folder / "Installed" / fmt::format("Coollab/res/{}/file_{}.txt", i % 7, i)) == fmt::format("Content of file {}", i));
+        CHECK(read_file(folder / "Installed/Coollab/big.bin") == std::string(3'000'000, 'x'));
+    }
+    SUBCASE("Cancelling is not an error")
+    {
+        auto const res = extract_zip(folder / "release.zip", folder / "Installed", [](float) {}, []() { return true; });
+        CHECK(res.has_value());
+    }
+    Cool::File::remove_folder(folder);
+}
+#endif
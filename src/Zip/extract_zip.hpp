@@ -0,0 +1,14 @@
+#pragma once
+#include "tl/expected.hpp"
+
+/// Name of each entry that has already been extracted, and the CRC of its content
+using AlreadyExtractedEntries = std::unordered_map<std::string, uint32_t>;
+
+/// Extracts all the files of the zip into `destination_folder`.
+/// The zip is memory-mapped and its entries are shared between several threads, because a release contains thousands of small files and extracting them one by one is dominated by the latency of opening and closing each file.
+/// If `wants_to_cancel()` returns true, the extraction stops (after the entries that are currently being extracted) and no error is returned.
+/// The entries listed in `already_extracted` (e.g. because they were extracted while the zip was still downloading) are not extracted again, we only restore their permissions, which are only known once we can read the central directory at the end of the zip.
+auto extract_zip(std::filesystem::path const& zip_path, std::filesystem::path const& destination_folder, std::function<void(float)> const& set_progress, std::function<bool()> const& wants_to_cancel, AlreadyExtractedEntries const& already_extracted = {})
+    -> tl::expected<void, std::string>;
+
+auto minizip_error_string(int32_t code) -> std::string;
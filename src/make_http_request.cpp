@@ -1,13 +1,15 @@
 #include "make_http_request.hpp"
+#include <fstream>
+#include <mutex>
+#include "Cool/File/File.h"
+#include "Cool/Serialization/Json.hpp"
 #include "Cool/String/String.h"
+#include "nlohmann/json.hpp"
 
-auto make_http_request(std::string_view url, std::function<bool(uint64_t current, uint64_t total)> progress_callback) -> httplib::Result
+/// On some Linux distros httplib doesn't find the ca certificates automatically, so we have to try a few paths manually
+static auto find_ca_bundle() -> std::optional<std::string>
 {
-    assert(url.starts_with("https://"));
-    auto cli = httplib::Client{std::string{Cool::String::substring(url, 0, url.find('/', "https://"sv.size()))}};
-
 #if defined(__linux__)
-    // On some Linux distros httplib doesn't find the ca certificates automatically, so we have to try a few paths manually
     static constexpr auto ca_paths = std::array{
         "/etc/ssl/certs/ca-certificates.crt",                // Debian/Ubuntu
         "/etc/pki/tls/certs/ca-bundle.crt",                  // RHEL/CentOS/Fedora
@@ -26,26 +28,301 @@ auto make_http_request(std::string_view url, std::function<bool(uint64_t current
     for (auto const& path : ca_paths)
     {
         if (Cool::File::exists(path))
-        {
-            cli.set_ca_cert_path(path);
-            break;
-        }
+            return path;
     }
 #endif
+    return std::nullopt;
+}
+
+/// "https://api.github.com/repos/Coollab-Art/Coollab/releases" -> "https://api.github.com"
+static auto origin(std::string_view url) -> std::string
+{
+    assert(url.starts_with("https://") || url.starts_with("http://")); // http is only used by the tests, to talk to a local server
+    return std::string{Cool::String::substring(url, 0, url.find('/', url.find("://") + "://"sv.size()))};
+}
+
+static auto make_client(std::string const& origin) -> std::unique_ptr<httplib::Client>
+{
+    auto cli = std::make_unique<httplib::Client>(origin);
 
+    static auto const ca_bundle = find_ca_bundle(); // Only look for it once, it won't move while the launcher is running
+    if (ca_bundle)
+        cli->set_ca_cert_path(*ca_bundle);
+
+    // Keep the connection open once the request is done, so that the next request to the same server doesn't need a new TCP and TLS handshake
+    cli->set_keep_alive(true);
     // If page has been moved but there is a redirection from the old url to the new one, follow it
-    cli.set_follow_location(true);
+    cli->set_follow_location(true);
     // Don't cancel if we have a bad internet connection. This is done in a Task so this is non-blocking anyways (NB: setting too big of a timeout (e.g. 99999h) caused the request to immediately fail on MacOS and Arch Linux)
-    cli.set_connection_timeout(15min);
-    cli.set_read_timeout(15min);
-    cli.set_write_timeout(15min);
+    cli->set_connection_timeout(15min);
+    cli->set_read_timeout(15min);
+    cli->set_write_timeout(15min);
+
+    return cli;
+}
+
+/// The clients (and their open connections) that are not currently used by a request, for each server
+/// A client can only do one request at a time, so when several threads talk to the same server (e.g. the segments of a download) each one gets its own client
+class ClientPool {
+public:
+    auto acquire(std::string const& origin) -> std::unique_ptr<httplib::Client>
+    {
+        {
+            auto  lock    = std::unique_lock{_mutex};
+            auto& clients = _idle_clients[origin];
+            if (!clients.empty())
+            {
+                auto client = std::move(clients.back());
+                clients.pop_back();
+                return client;
+            }
+        }
+        return make_client(origin); // Outside of the lock, to not block the other threads
+    }
+
+    void release(std::string const& origin, std::unique_ptr<httplib::Client> client)
+    {
+        auto  lock    = std::unique_lock{_mutex};
+        auto& clients = _idle_clients[origin];
+        if (clients.size() < max_nb_of_idle_clients_per_origin)
+            clients.push_back(std::move(client));
+    }
+
+private:
+    static constexpr size_t max_nb_of_idle_clients_per_origin{8};
+
+    std::mutex                                                                     _mutex{};
+    std::unordered_map<std::string, std::vector<std::unique_ptr<httplib::Client>>> _idle_clients{};
+};
 
-    auto res = cli.Get(std::string{url}, std::move(progress_callback));
+static auto client_pool() -> ClientPool&
+{
+    static auto instance = ClientPool{};
+    return instance;
+}
+
+/// Takes a client from the pool, and gives it back once the request is done
+class PooledClient {
+public:
+    explicit PooledClient(std::string_view url)
+        : _origin{origin(url)}
+        , _client{client_pool().acquire(_origin)}
+    {}
+    ~PooledClient() { client_pool().release(_origin, std::move(_client)); }
+    PooledClient(PooledClient const&)                = delete;
+    PooledClient& operator=(PooledClient const&)     = delete;
+    PooledClient(PooledClient&&) noexcept            = delete;
+    PooledClient& operator=(PooledClient&&) noexcept = delete;
+
+    auto operator->() -> httplib::Client* { return _client.get(); }
+
+private:
+    std::string                      _origin;
+    std::unique_ptr<httplib::Client> _client;
+};
+
+static auto is_success(int status) -> bool
+{
+    return status == 200 || status == 206 || status == 304; // 206 is the answer to a Range request, and 304 to a conditional request
+}
 
+static void log_errors(httplib::Result const& res)
+{
     if (!res)
         Cool::Log::internal_warning("make_http_request", httplib::to_string(res.error()));
-    else if (res->status != 200)
+    else if (!is_success(res->status))
         Cool::Log::internal_warning("make_http_request", fmt::format("Error {}\n{}", std::to_string(res->status), res->body));
+}
+
+auto make_http_request(std::string_view url, std::function<bool(uint64_t current, uint64_t total)> progress_callback) -> httplib::Result
+{
+    auto cli = PooledClient{url};
+    auto res = cli->Get(std::string{url}, std::move(progress_callback));
+    log_errors(res);
+    return res;
+}
+
+/// The validators are stored next to the body, and are only valid for that body
+static auto validators_path(std::filesystem::path const& cached_body_path) -> std::filesystem::path
+{
+    return cached_body_path.string() + ".validators.json";
+}
+
+static auto load_validators(std::string_view url, std::filesystem::path const& cached_body_path) -> httplib::Headers
+{
+    if (!Cool::File::exists(cached_body_path))
+        return {};
+    auto file = std::ifstream{validators_path(cached_body_path)};
+    if (!file.is_open())
+        return {};
+
+    try
+    {
+        auto const json          = nlohmann::json::parse(file);
+        auto       validator_url = std::string{};
+        Cool::json_get(json, "URL", validator_url);
+        if (validator_url != url)
+            return {};
+
+        auto headers = httplib::Headers{};
+        if (json.contains("ETag"))
+            headers.emplace("If-None-Match", json.at("ETag").get<std::string>());
+        if (json.contains("Last-Modified"))
+            headers.emplace("If-Modified-Since", json.at("Last-Modified").get<std::string>());
+        return headers;
+    }
+    catch (std::exception const& e)
+    {
+        Cool::Log::internal_warning("make_http_request", e.what());
+        return {};
+    }
+}
+
+static void save_body_and_validators(std::string_view url, std::filesystem::path const& cached_body_path, httplib::Response const& response)
+{
+    Cool::File::set_content(cached_body_path, response.body);
+
+    auto json = nlohmann::json{};
+    Cool::json_set(json, "URL", std::string{url});
+    if (response.has_header("ETag"))
+        json["ETag"] = response.get_header_value("ETag");
+    if (response.has_header("Last-Modified"))
+        json["Last-Modified"] = response.get_header_value("Last-Modified");
+    Cool::File::set_content(validators_path(cached_body_path), json.dump());
+}
+
+auto make_conditional_http_request(std::string_view url, std::filesystem::path const& cached_body_path, std::function<bool(uint64_t current, uint64_t total)> progress_callback) -> httplib::Result
+{
+    auto cli = PooledClient{url};
+    auto res = cli->Get(std::string{url}, load_validators(url, cached_body_path), std::move(progress_callback));
+    log_errors(res);
+    if (!res)
+        return res;
+
+    if (res->status == 200)
+    {
+        save_body_and_validators(url, cached_body_path, *res);
+    }
+    else if (res->status == 304)
+    {
+        auto file = std::ifstream{cached_body_path, std::ios::binary};
+        res->body = std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+    return res;
+}
+
+auto next_page_url(httplib::Response const& response) -> std::optional<std::string>
+{
+    if (!response.has_header("Link"))
+        return std::nullopt;
+    auto const links = response.get_header_value("Link");
+
+    auto begin = size_t{0};
+    while (begin < links.size())
+    {
+        auto const end  = std::min(links.find(',', begin), links.size());
+        auto const link = std::string_view{links}.substr(begin, end - begin);
+        begin           = end + 1;
+
+        auto const url_begin = link.find('<');
+        auto const url_end   = link.find('>');
+        if (url_begin == std::string_view::npos || url_end == std::string_view::npos || url_end < url_begin)
+            continue;
+        if (link.find("rel=\"next\"", url_end) != std::string_view::npos)
+            return std::string{link.substr(url_begin + 1, url_end - url_begin - 1)};
+    }
+    return std::nullopt;
+}
+
+auto make_http_head_request(std::string_view url) -> httplib::Result
+{
+    auto cli = PooledClient{url};
+    auto res = cli->Head(std::string{url});
+    log_errors(res);
+    return res;
+}
 
+auto make_http_request(std::string_view url, httplib::Headers const& headers, httplib::ResponseHandler response_handler, httplib::ContentReceiver content_receiver, std::function<bool(uint64_t current, uint64_t total)> progress_callback) -> httplib::Result
+{
+    auto cli = PooledClient{url};
+
+    auto response_is_success = false;
+    auto res                 = cli->Get(
+        std::string{url}, headers,
+        [&](httplib::Response const& response) {
+            response_is_success = is_success(response.status);
+            return response_handler(response);
+        },
+        [&](char const* data, size_t length) {
+            if (!response_is_success)
+                return true; // Don't forward error pages to the receiver, they are not part of the content that was requested
+            return content_receiver(data, length);
+        },
+        std::move(progress_callback)
+    );
+    log_errors(res);
     return res;
-}
\ No newline at end of file
+}
+
+#if defined(COOLLAB_LAUNCHER_TESTS)
+#include "doctest/doctest.h"
+#include "Testing/LocalFileServer.hpp"
+
+TEST_CASE("Clients are reused for the same server")
+{
+    auto pool = ClientPool{};
+
+    auto        client       = pool.acquire("https://api.github.com");
+    auto const* first_client = client.get();
+    pool.release("https://api.github.com", std::move(client));
+
+    auto const other_server = pool.acquire("https://github.com");
+    CHECK(other_server.get() != first_client);
+    auto const same_server = pool.acquire("https://api.github.com");
+    CHECK(same_server.get() == first_client);
+    auto const same_server_while_first_is_busy = pool.acquire("https://api.github.com");
+    CHECK(same_server_while_first_is_busy.get() != first_client);
+
+    CHECK(origin("https://api.github.com/repos/Coollab-Art/Coollab/releases") == "https://api.github.com");
+    CHECK(origin("http://127.0.0.1:1234/asset") == "http://127.0.0.1:1234");
+}
+
+TEST_CASE("Url of the next page")
+{
+    auto response = httplib::Response{};
+    CHECK(!next_page_url(response).has_value());
+    response.set_header("Link", R"(<https://api.github.com/repositories/1/releases?per_page=100&page=2>; rel="next", <https://api.github.com/repositories/1/releases?per_page=100&page=3>; rel="last")");
+    CHECK(next_page_url(response) == "https://api.github.com/repositories/1/releases?per_page=100&page=2");
+
+    auto last_page = httplib::Response{};
+    last_page.set_header("Link", R"(<https://api.github.com/repositories/1/releases?per_page=100&page=1>; rel="first", <https://api.github.com/repositories/1/releases?per_page=100&page=2>; rel="prev")");
+    CHECK(!next_page_url(last_page).has_value());
+}
+
+TEST_CASE("Conditional requests reuse the cached body")
+{
+    auto const folder = std::filesystem::temp_directory_path() / "Coollab-Launcher-Tests" / "conditional_request";
+    auto const cached = folder / "body.txt";
+    Cool::File::remove_folder(folder);
+    auto const server = LocalFileServer{"Hello"};
+
+    auto const first = make_conditional_http_request(server.url(), cached, {});
+    REQUIRE(first);
+    CHECK(first->status == 200);
+    CHECK(first->body == "Hello");
+
+    auto const second = make_conditional_http_request(server.url(), cached, {});
+    REQUIRE(second);
+    CHECK(second->status == 304);
+    CHECK(second->body == "Hello");
+
+    // Without the cached body, the validators are useless
+    Cool::File::remove_file(cached);
+    auto const third = make_conditional_http_request(server.url(), cached, {});
+    REQUIRE(third);
+    CHECK(third->status == 200);
+    CHECK(third->body == "Hello");
+
+    Cool::File::remove_folder(folder);
+}
+#endif
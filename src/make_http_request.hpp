@@ -1,4 +1,15 @@
 #pragma once
 #include "httplib.h"
 
-auto make_http_request(std::string_view url, std::function<bool(uint64_t current, uint64_t total)> progress_callback) -> httplib::Result;
\ No newline at end of file
+auto make_http_request(std::string_view url, std::function<bool(uint64_t current, uint64_t total)> progress_callback) -> httplib::Result;
+/// Sends the ETag / Last-Modified that the server gave us the last time, so that it can answer "304 Not Modified" instead of sending the whole content again (on Github, such answers don't count against the rate limit).
+/// The last content we received is kept in `cached_body_path`, and on a 304 it is put in the body of the result, so callers can use it just like a 200. The status is kept to 304, so that callers can skip their work if the content hasn't changed.
+auto make_conditional_http_request(std::string_view url, std::filesystem::path const& cached_body_path, std::function<bool(uint64_t current, uint64_t total)> progress_callback) -> httplib::Result;
+/// Paginated APIs (like Github's) give the url of the next page in a "Link" header: `<https://...?page=2>; rel="next", <https://...?page=5>; rel="last"`
+/// Returns nullopt if the response doesn't have a next page
+auto next_page_url(httplib::Response const&) -> std::optional<std::string>;
+/// Only gets the status and headers of the response, e.g. to know the size of a file before downloading it
+auto make_http_head_request(std::string_view url) -> httplib::Result;
+/// Streams the body of the response to the content_receiver, chunk by chunk, instead of accumulating it in the returned Result
+/// The response_handler is called with the status and headers of the response, before any content is received. It can return false to cancel the request.
+auto make_http_request(std::string_view url, httplib::Headers const& headers, httplib::ResponseHandler response_handler, httplib::ContentReceiver content_receiver, std::function<bool(uint64_t current, uint64_t total)> progress_callback) -> httplib::Result;